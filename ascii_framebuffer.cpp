@@ -0,0 +1,410 @@
+#include "ascii_framebuffer.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+void ascii_framebuffer_t::dither(bool useZbuffer)
+{
+    resolve_clears();
+
+    with_depth([&](auto format, auto depth) { dither(format, depth, useZbuffer); });
+}
+
+template <typename format_t>
+void ascii_framebuffer_t::dither(format_t format, const typename format_t::value_t* depth, bool useZbuffer)
+{
+    const auto palette_size = (float)palette.size();
+
+    const auto width = this->width;
+    const auto height = this->height;
+
+    const auto k1Per15 = 1.0f / (palette_size - 1);
+    const auto k1Per16 = 1.0f / 16.0f;
+    const auto k3Per16 = 3.0f / 16.0f;
+    const auto k5Per16 = 5.0f / 16.0f;
+    const auto k7Per16 = 7.0f / 16.0f;
+
+    // Error spreads less across depth discontinuities
+    const auto depth_weight = [&](const auto* a, const auto* b)
+    {
+        return useZbuffer ? std::clamp(1.0f - fabsf(format.decode(*a) - format.decode(*b)), 0.0f, 1.0f) : 1.0f;
+    };
+
+    for (auto& done : dither_progress)
+        done.store(0, std::memory_order_relaxed);
+
+    // Rows run as a wavefront, every row follows the one above. Before a cell
+    // passes error to its right neighbour all three cells above that neighbour
+    // have to be done, so every cell sums error in the same order as a single
+    // pass over the grid would. Pool starts rows in order, row waits only for
+    // one already running.
+    get_thread_pool().parallel_for(height, [&](int y)
+    {
+        const auto above = y > 0 ? &dither_progress[y - 1] : nullptr;
+        auto&      done  = dither_progress[y];
+
+        int ready = above ? 0 : width;
+
+        auto pixel = color.data() + y * width;
+        auto cell_depth = depth + y * width;
+        for (int x = 0; x < width; ++x, ++pixel, ++cell_depth)
+        {
+            const auto needed = std::min(width, x + 3);
+            while (ready < needed)
+            {
+                above->wait(ready, std::memory_order_acquire);
+                ready = above->load(std::memory_order_acquire);
+            }
+
+            auto c = *pixel;
+            auto c2 = std::min(1.0f, std::max(0.0f, floorf(c * palette_size) * k1Per15));
+            auto ce = c - c2;
+
+            *pixel = c2;
+
+            auto n1 = pixel + 1;
+            auto n2 = pixel + width - 1;
+            auto n3 = pixel + width;
+            auto n4 = pixel + width + 1;
+
+            auto d1 = cell_depth + 1;
+            auto d2 = cell_depth + width - 1;
+            auto d3 = cell_depth + width;
+            auto d4 = cell_depth + width + 1;
+
+            if (x < width - 1)
+                *n1 += (ce * k7Per16) * depth_weight(cell_depth, d1);
+
+            if (y < height - 1)
+            {
+                *n3 += ce * k5Per16 * depth_weight(cell_depth, d3);
+
+                if (x > 0)
+                    *n2 += ce * k3Per16 * depth_weight(cell_depth, d2);
+
+                if (x < width - 1)
+                    *n4 += ce * k1Per16 * depth_weight(cell_depth, d4);
+            }
+
+            // Progress is published in steps, waking row below costs more than a cell
+            if ((x & 15) == 15 || x == width - 1)
+            {
+                done.store(x + 1, std::memory_order_release);
+                done.notify_all();
+            }
+        }
+    });
+}
+
+// Level of every lane is floor(c * levels + threshold), thresholds are
+// spread evenly over [0, 1), so levels average to c.
+template <typename lanes>
+static int dither_ordered_row(float* row, const float* thresholds, int x, int count, float levels)
+{
+    const auto zero      = lanes::splat(0.0f);
+    const auto top       = lanes::splat(levels);
+    const auto per_level = lanes::splat(1.0f / levels);
+
+    for (; x + lanes::count <= count; x += lanes::count)
+    {
+        const auto c     = lanes::max(lanes::load(row + x), zero);
+        const auto level = lanes::min(lanes::to_float(lanes::to_int(c * top + lanes::load(thresholds + x))), top);
+
+        lanes::store(row + x, level * per_level);
+    }
+
+    return x;
+}
+
+void ascii_framebuffer_t::dither_ordered(const dither_mask_t& mask)
+{
+    resolve_clears();
+
+    if (thresholds_mask != &mask)
+    {
+        thresholds_mask = &mask;
+        thresholds.resize(static_cast<size_t>(mask.size) * width);
+
+        const auto scale = 1.0f / (mask.size * mask.size);
+        for (int y = 0; y < mask.size; ++y)
+            for (int x = 0; x < width; ++x)
+                thresholds[x + y * width] = (mask.ranks[x % mask.size + y * mask.size] + 0.5f) * scale;
+    }
+
+    const auto levels = (float)(palette.size() - 1);
+
+    get_thread_pool().parallel_for(static_cast<int>(bands.size()), [&](int index)
+    {
+        for (int y = bands[index].y0; y < bands[index].y1; ++y)
+        {
+            const auto row = color.data() + y * width;
+            const auto threshold_row = thresholds.data() + (y % mask.size) * width;
+
+            const auto x = dither_ordered_row<simd_lanes_t>(row, threshold_row, 0, width, levels);
+            dither_ordered_row<scalar_lanes_t>(row, threshold_row, x, width, levels);
+        }
+    });
+}
+
+void ascii_framebuffer_t::commit_impl()
+{
+    const auto clear = color_to_gray8(deferred_color);
+    const auto diff  = diff_cells && cells_known && clear == cells_clear;
+
+    if (!diff)
+    {
+        // Cells are drawn over cleared target, empty ones are skipped
+        buffer.clear(deferred_color);
+
+        cells_known = buffer.copy_gray8_2d(0, 0, 0, 0, nullptr, 0);
+        cells_clear = clear;
+
+        if (!cells_known)
+        {
+            changed_cells = width * height;
+            commit_chars();
+            return;
+        }
+    }
+
+    // Bands write disjoint cells and tiles, output does not depend on order
+    get_thread_pool().parallel_for(static_cast<int>(bands.size()), [this, diff](int index)
+    {
+        auto& band = bands[index];
+        band.changed = diff ? commit_cells(band) : commit_tiles(band);
+    });
+
+    changed_cells = std::accumulate(bands.begin(), bands.end(), 0, [](int sum, const band_t& band) { return sum + band.changed; });
+}
+
+void ascii_framebuffer_t::invalidate()
+{
+    cells_known = false;
+}
+
+void ascii_framebuffer_t::invalidate(const rect_t& rect)
+{
+    const auto x0 = std::max(0, rect.x0 / font_width);
+    const auto y0 = std::max(0, rect.y0 / font_height);
+    const auto x1 = std::min(width,  (rect.x1 + font_width  - 1) / font_width);
+    const auto y1 = std::min(height, (rect.y1 + font_height - 1) / font_height);
+
+    for (int y = y0; y < y1; ++y)
+        for (int x = x0; x < x1; ++x)
+            cells[x + y * width] = cell_unknown;
+}
+
+// Widths of bundled fonts get fixed size copies, compiled to plain moves.
+template <int w>
+static void copy_glyph_rows(uint8_t* out, int pitch, const uint8_t* tile, int h)
+{
+    for (int row = 0; row < h; ++row, tile += w, out += pitch)
+        std::memcpy(out, tile, w);
+}
+
+void ascii_framebuffer_t::compose_cells(const uint16_t* codes, int count, uint8_t* out, int pitch, uint8_t clear) const
+{
+    const auto tile_size = font.w * font.h;
+
+    for (int row = 0; row < font_height; ++row)
+        std::memset(out + row * pitch, clear, static_cast<size_t>(count) * font_width);
+
+    for (int x = 0; x < count; ++x, out += font_width)
+    {
+        if (codes[x] == 0)
+            continue;
+
+        auto tile = glyph_tiles.data() + (codes[x] - 1) * tile_size;
+        switch (font.w)
+        {
+            case 5:  copy_glyph_rows<5>(out, pitch, tile, font.h); break;
+            case 8:  copy_glyph_rows<8>(out, pitch, tile, font.h); break;
+            default:
+                for (int row = 0; row < font.h; ++row, tile += font.w)
+                    std::memcpy(out + row * pitch, tile, font.w);
+                break;
+        }
+    }
+}
+
+int ascii_framebuffer_t::commit_tiles(band_t& band)
+{
+    const auto pitch = width * font_width;
+    const auto clear = cells_clear;
+
+    // Band is copied in whole rows of target tiles, so no tile is cleared just
+    // to be overwritten. Rows left over are carried to the next row of cells.
+    int band_y    = band.y0 * font_height;
+    int band_rows = 0;
+
+    for (int y = band.y0; y < band.y1; ++y)
+    {
+        const auto codes = cells.data() + y * width;
+
+        cell_codes(color.data() + y * width, codes, width);
+
+        compose_cells(codes, width, band.pixels.data() + static_cast<size_t>(band_rows) * pitch, pitch, clear);
+
+        band_rows += font_height;
+
+        const auto rows = y < band.y1 - 1 ? band_rows - (band_y + band_rows) % depth_tile_size : band_rows;
+        if (rows <= 0)
+            continue;
+
+        buffer.copy_gray8_2d(0, band_y, pitch, rows, band.pixels.data(), pitch);
+
+        band_y    += rows;
+        band_rows -= rows;
+
+        std::memmove(band.pixels.data(), band.pixels.data() + static_cast<size_t>(rows) * pitch, static_cast<size_t>(band_rows) * pitch);
+    }
+
+    return (band.y1 - band.y0) * width;
+}
+
+// Runs of changed cells in a row are composed and copied together, target
+// marks only tiles they cover as dirty.
+int ascii_framebuffer_t::commit_cells(band_t& band)
+{
+    const auto clear = cells_clear;
+
+    int changed = 0;
+
+    for (int y = band.y0; y < band.y1; ++y)
+    {
+        const auto row   = band.codes.data();
+        const auto codes = cells.data() + y * width;
+
+        cell_codes(color.data() + y * width, row, width);
+
+        for (int x = 0; x < width;)
+        {
+            if (row[x] == codes[x])
+            {
+                ++x;
+                continue;
+            }
+
+            const auto x0 = x;
+            do
+            {
+                codes[x] = row[x];
+                ++x;
+            }
+            while (x < width && row[x] != codes[x]);
+
+            const auto pitch = (x - x0) * font_width;
+
+            compose_cells(codes + x0, x - x0, band.pixels.data(), pitch, clear);
+
+            buffer.copy_gray8_2d(x0 * font_width, y * font_height, pitch, font_height, band.pixels.data(), pitch);
+
+            changed += x - x0;
+        }
+    }
+
+    return changed;
+}
+
+void ascii_framebuffer_t::commit_chars()
+{
+    auto& codes = bands[0].codes;
+
+    for (int y = 0; y < height; ++y)
+    {
+        cell_codes(color.data() + y * width, codes.data(), width);
+
+        for (int x = 0; x < width; ++x)
+            if (codes[x])
+                buffer.char_2d(font, x * font_width, y * font_height, palette[codes[x] - 1], 1.0f);
+    }
+}
+
+// Exact zero stays empty cell, anything else is looked up by its fixed point
+// intensity.
+template <typename lanes>
+static int cell_codes_lanes(const float* c, uint16_t* codes, int x, int count, const uint16_t* table)
+{
+    const auto zero  = lanes::splat(0.0f);
+    const auto scale = lanes::splat(static_cast<float>(intensity_max + 1));
+    const auto top   = lanes::splat(static_cast<float>(intensity_max));
+
+    for (; x + lanes::count <= count; x += lanes::count)
+    {
+        const auto v = lanes::load(c + x);
+
+        // max() and min() return first operand for NaN, keeps index in the table
+        int32_t fixed[lanes::count];
+        lanes::store(fixed, lanes::to_int(lanes::min(top, lanes::max(zero, v * scale))));
+
+        const auto empty = lanes::less_equal(v, zero) & lanes::greater_equal(v, zero);
+
+        for (int i = 0; i < lanes::count; ++i)
+            codes[x + i] = (empty & (1u << i)) ? 0 : table[fixed[i]];
+    }
+
+    return x;
+}
+
+void ascii_framebuffer_t::cell_codes(const float* c, uint16_t* codes, int count) const
+{
+    const auto x = cell_codes_lanes<simd_lanes_t>(c, codes, 0, count, code_table.data());
+    cell_codes_lanes<scalar_lanes_t>(c, codes, x, count, code_table.data());
+}
+
+void ascii_framebuffer_t::build_glyph_tiles()
+{
+    const auto tile_size = font.w * font.h;
+
+    const auto foreground = color_to_gray8(1.0f);
+    const auto background = color_to_gray8(0.0f);
+
+    glyph_tiles.assign(palette.size() * tile_size, background);
+    glyph_missing.assign(palette.size(), false);
+
+    for (size_t i = 0; i < palette.size(); ++i)
+    {
+        auto glyph = font.find(palette[i]);
+        if (!glyph)
+        {
+            glyph_missing[i] = true;
+            continue;
+        }
+
+        auto tile = glyph_tiles.data() + i * tile_size;
+        for (int y = 0; y < font.h; ++y)
+            for (int x = 0; x < font.w; ++x)
+                if (font.pixel(glyph, x, y))
+                    tile[x + y * font.w] = foreground;
+    }
+
+    // Intensity range is split evenly between palette characters
+    code_table.resize(intensity_max + 1);
+    for (int i = 0; i <= intensity_max; ++i)
+    {
+        const auto index = static_cast<int>((palette.size() * i) >> intensity_bits);
+
+        code_table[i] = glyph_missing[index] ? 0 : static_cast<uint16_t>(index + 1);
+    }
+}
+
+void ascii_framebuffer_t::build_bands()
+{
+    // Rows of cells starting on a row of depth tiles come every 'step' rows
+    const auto step   = depth_tile_size / std::gcd(font_height, depth_tile_size);
+    const auto groups = (height + step - 1) / step;
+    const auto count  = std::max(1, std::min(groups, get_thread_pool().thread_count() * 4));
+
+    bands.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        auto& band = bands[i];
+        band.y0 = std::min(height, groups * i / count * step);
+        band.y1 = std::min(height, groups * (i + 1) / count * step);
+        band.pixels.resize(static_cast<size_t>(width) * font_width * (font_height + depth_tile_size - 1));
+        band.codes.resize(width);
+        band.changed = 0;
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include "drawing.h"
+#include "simd.h"
+#include "dither_mask.h"
+#include <vector>
+#include <atomic>
+#include <cstring>
+
+struct ascii_font_t
+{
+    const font_t& font;
+    const char*   palette;
+    const int     padding;
+};
+
+// Renders to a grid of cells, commit() draws every cell as a character of
+// palette to the target buffer. Target is expected to keep its content between
+// frames, only cells whose character changed since last commit are drawn
+// again. Whoever else draws to the target has to invalidate() that area.
+struct ascii_framebuffer_t final: concrete_framebuffer_t<ascii_framebuffer_t>
+{
+    friend concrete_framebuffer_t;
+
+    framebuffer_t&     buffer;
+    const font_t&      font;
+    std::vector<float> color;
+    int                font_width;
+    int                font_height;
+    std::vector<char>  palette;
+
+    // Rows of cells committed by one job of thread pool. Bands start and end
+    // on rows of target depth tiles, so no tile is written by two jobs.
+    struct band_t
+    {
+        int                  y0, y1;        // rows of cells
+        std::vector<uint8_t>  pixels;       // composed cells waiting for copy
+        std::vector<uint16_t> codes;        // cells of row being committed
+        int                   changed;
+    };
+
+    // Glyph of every palette character pre-rendered as gray8 pixels. Targets
+    // accepting copy_gray8_2d() get runs of cells composed in band pixels and
+    // copied at once, padding and empty cells included.
+    std::vector<uint8_t> glyph_tiles;
+    std::vector<bool>    glyph_missing;     // font has no glyph, cell is left clear
+
+    // Cell code of every fixed point intensity (see intensity_bits), colors are
+    // turned into cells a row at a time through it.
+    std::vector<uint16_t> code_table;
+    std::vector<band_t>  bands;
+
+    // What target shows in every cell: 0 - clear, palette index + 1 - glyph.
+    // Set when copy_gray8_2d() is accepted, target is drawn whole otherwise.
+    std::vector<uint16_t> cells;
+    bool                  cells_known  = false;
+    uint8_t               cells_clear  = 0;
+    bool                  diff_cells   = true;  // false draws every cell every commit
+    int                   changed_cells = 0;    // drawn by last commit
+
+    std::vector<std::atomic<int>> dither_progress;    // cells of every row dither() finished
+
+    // Thresholds of last mask given to dither_ordered(), 'size' rows of 'width'
+    const dither_mask_t*  thresholds_mask = nullptr;
+    std::vector<float>    thresholds;
+
+    ascii_framebuffer_t(framebuffer_t& buffer, const ascii_font_t& font):
+        concrete_framebuffer_t(buffer.width / (font.font.w + font.padding), buffer.height / (font.font.h + font.padding)),
+        buffer(buffer),
+        font(font.font),
+        color(width * height),
+        font_width(font.font.w + font.padding),
+        font_height(font.font.h + font.padding),
+        palette(font.palette, font.palette + strlen(font.palette)),
+        cells(width * height, cell_unknown),
+        dither_progress(height)
+    {
+        build_glyph_tiles();
+        build_bands();
+    }
+
+    void dither(bool useZbuffer);
+
+    // Rounds every cell up or down to a palette level by comparing it with
+    // threshold of 'mask' tiled over grid. Cells do not depend on each other
+    // and stay the same while their color does.
+    void dither_ordered(const dither_mask_t& mask);
+
+    // Next commit draws every cell, or cells covering 'rect' of target.
+    void invalidate();
+    void invalidate(const rect_t& rect);
+
+private:
+    static constexpr uint16_t cell_unknown = 0xFFFF;
+
+    void build_glyph_tiles();
+    void build_bands();
+    int  commit_tiles(band_t& band);
+    int  commit_cells(band_t& band);
+    void commit_chars();
+    void compose_cells(const uint16_t* codes, int count, uint8_t* out, int pitch, uint8_t clear) const;
+    void cell_codes(const float* c, uint16_t* codes, int count) const;
+
+    template <typename format_t>
+    void dither(format_t format, const typename format_t::value_t* depth, bool useZbuffer);
+
+protected:
+    virtual void clear_color(int y0, int y1, float c) override final
+    {
+        stream_fill(color.data() + y0 * width, static_cast<size_t>(y1 - y0) * width, c);
+    }
+
+    virtual void set_color(int x, int y, float c) override final
+    {
+        color[x + y * width] = c;
+    }
+
+    virtual void blend_color(int x, int y, float c, float a) override final
+    {
+        color[x + y * width] += (c - color[x + y * width]) * a;
+    }
+
+    virtual void fill_color_span(int x, int y, int count, float c) override final
+    {
+        std::fill_n(color.data() + x + y * width, count, c);
+    }
+
+    virtual void set_color_span(int x, int y, int count, const float* c, uint32_t mask) override final
+    {
+        auto out = color.data() + x + y * width;
+        for (int i = 0; i < count; ++i)
+            if (mask & (1u << i))
+                out[i] = c[i];
+    }
+
+    virtual void blend_color_span(int x, int y, int count, const float* c, const float* a, uint32_t mask) override final
+    {
+        auto out = color.data() + x + y * width;
+        for (int i = 0; i < count; ++i)
+            if (mask & (1u << i))
+                out[i] += (c[i] - out[i]) * a[i];
+    }
+
+    virtual void commit_impl() override final;
+
+    virtual void present_impl() override final
+    {
+        buffer.present();
+    }
+};
@@ -0,0 +1,273 @@
+#include "dither_mask.h"
+
+// Generated with void-and-cluster (Ulichney), gaussian sigma 1.5, wrapping
+// at edges so the mask tiles without seams.
+static const uint16_t s_blue_noise_64x64_ranks[64 * 64] =
+{
+    4013, 1961,  511, 2219, 3903, 1270, 1676,  709, 2807,  188, 3794,  680, 2914, 1914, 3769,  774,
+    2010, 3706,  282, 3299, 1990, 1333, 3101, 3543,  206, 2544,  891, 3797, 1272, 2002, 3876,  382,
+    1750, 2926, 2022,   43, 3742, 2978, 1564, 2080, 2849, 3692, 3078, 1796, 3362, 3930, 2193, 3720,
+    2607, 1090, 1911,  358, 3470, 1473,  146, 1873,  564, 3082, 3646,  797, 1884, 3880,  980, 2725,
+      60, 3116, 3704, 2784,  817, 3422,   18, 3834, 3265, 1738, 2370, 3489, 1459,  353, 3090, 1620,
+    3344, 2804, 1742, 2460, 1008, 2823,  408, 2266, 4095, 2962, 1659,  413, 3098, 2581, 1095, 3195,
+    1405, 4004,  737, 3269, 1825,  525, 4087, 1182,  135, 1017, 2142,  801,   85, 2433,  864,  384,
+    1612, 3598, 2465, 4029,  672, 2177,  963, 3736, 1306, 1672, 2113, 2474, 1274, 2945, 2223, 1458,
+    2414, 1669, 1235,  247, 1816, 2995, 2082, 2513,  868, 1226,  405, 2028,  941, 4057, 2335, 1124,
+      89, 1359,  692, 3631,  123, 3863, 1497, 1921,  701, 1173, 2154, 3634,  766, 1787,  138, 3586,
+    2383,  291, 2517, 1110, 1446, 2306, 3150, 2614, 3434, 1633, 2497, 3772, 1428, 2976, 1826, 2774,
+    3188,  492, 1390, 3037, 1754, 2743, 3174, 2480, 3345,   14, 3975,  497, 3412,  202, 3746,  644,
+    2883,  919, 3457, 2458, 3254, 1051,  519, 1463, 2756, 3965, 3335, 2610, 3014, 1713,  568, 3446,
+    2559, 3982, 3015, 2215, 1631, 3371,  910, 3161, 2609,   19, 3248, 2482, 1474, 3970, 2761, 2092,
+     863, 1662, 2893, 3798, 3403,  880,  340, 1854,  674, 3944,  381, 3141,  571, 3505, 1178, 4000,
+    2096,  953, 2275,  110, 1181, 3812,  304, 2000,  716, 2779, 1038, 1581, 2602,  901, 1779, 3341,
+     345, 3895, 2126,  651, 1549, 4093, 2365, 3610,  136, 1862,  713, 1290,  182, 3567, 2793, 2121,
+     887, 1952,  432, 1100, 2657,  598, 2333, 3763, 1328, 3486, 1843, 1022,  262, 3334,  620, 1284,
+    3095, 3483,  529, 2081,  103, 2457, 3838, 1362, 2228, 2757, 1170, 1936, 2672, 2209,  189,  679,
+    1499, 3767, 3304, 2652, 3518,  607, 1589, 1136, 3542, 2300, 3134, 3615, 2079, 3062, 1207, 1997,
+    2618, 1442,  131, 3642, 2834,  286, 1920, 2959, 1099, 3108, 2166, 3821, 2409,  820, 1433,  300,
+    3820, 1580, 3177, 3568, 1902, 2964,  181, 1732,  458, 2759,  638, 3729, 3004, 2034, 2416, 3822,
+     172, 1959, 1043, 2733, 1597, 3046, 1014, 2910, 3628,    4, 3318, 1551,  939, 3868, 1656, 3048,
+    2520,  292, 1716,  857, 2030, 2408, 2898, 4079, 1749,  418, 1380,  243,  729, 4038,  461, 3626,
+    1031, 3055, 1793, 2585,  937, 1288, 3388,  777, 1684, 3689,  320, 1542, 3308, 1899, 3699, 2996,
+    1143, 2705,   32,  821, 1417, 4018, 1154, 3089, 2057, 3963, 2296, 1197, 1694,  443,  990, 1585,
+    2660, 3660, 1399, 4032,  714, 3533, 1985,  494, 1683,  847, 2171, 3591,  273, 3199, 2321, 3487,
+    1117, 2894,  562, 3968, 1277, 3353,   86,  872, 2200, 2691, 3800, 1845, 2397, 2813, 1635, 2271,
+     572, 3998,  806, 3305, 2060, 3750, 2273,  421, 2683, 2355,  633, 2747, 1028,   68, 2507,  685,
+    2197, 3454, 2430, 3777, 2160,  315, 2530, 3619,  884, 1439,  124, 3426, 2493, 4063, 2946, 3293,
+     681, 2313,  299, 3183, 2249,  236, 1267, 3303, 2572, 4048, 2862,  608, 1976, 1314,  781,  137,
+    1954, 3641, 2245, 2723,  369, 1851, 3052, 1471, 3406,  667, 3032, 1032, 3306, 1343,  193, 3253,
+    1970, 1365, 2372,  444, 1557,  104, 3103, 1448, 3471, 1185, 4021, 3180, 2078, 3857, 1646, 3156,
+     420, 1337, 1778,  585, 2771, 3395, 1625,  605, 2413, 3271, 1860, 2775,  753, 1407,   66, 1928,
+    1137, 3400, 1652,  940, 1839, 2667, 3902, 2299,  180, 1109, 1441, 2452, 3717, 2938, 2608, 4036,
+    1401,  888, 3148, 1517, 3725, 1040, 2509, 3891,  303, 1295, 2055,   58, 3909,  798, 3563, 2687,
+    3765,   21, 3507, 2993, 3949, 2534,  996, 3825, 2026,  207, 1834, 1414,  448, 2833,  859, 3528,
+    1986, 4077,  920, 3260, 1260, 1984, 1002, 2848,  219, 3860, 1096,  412, 3770, 2234, 3597, 2569,
+     389, 3951, 2487, 2989, 3666,  542, 1500,  796, 3029, 1831, 3204,  325,  954, 1730,  469, 2162,
+    3401, 1819,   37,  748, 2019, 3441,  600, 1707, 2836, 2358, 3740, 1524, 2536, 2140, 1726, 1134,
+    2229, 2851, 1824,  683, 1206, 1889,  487, 2719,  725, 3002,  906, 2560, 3449, 1211, 2343, 1484,
+     208, 2586, 2961,  126, 3730,  416, 3943, 3181, 2191, 1537, 2984, 2050, 3152,  911, 1680, 2870,
+    1285, 2005,  767,   30, 1205, 2844, 3358, 2044, 3756,  516, 3546, 2125, 3896, 3321, 1254, 3008,
+     342, 2642, 3901, 2388, 2934,  220, 2181, 1155, 3613,  760, 3137,  438, 2874,  597, 3084,  349,
+    3215, 1541, 1045, 2704, 2206, 3059, 3438, 1642, 2246, 3357, 3773, 2187,  161, 3964,  584, 3074,
+    3752, 1078, 2149, 1462, 2324, 2636, 1800, 1296,  828, 3658,  652, 2600, 1325,  216, 3316,  555,
+    3755, 3083, 1525, 3845, 2183, 1746,  310, 1064, 2407, 1320, 2658, 1598,  127, 2488,  756, 3809,
+    1072, 1574, 3246,  984, 1370, 3979, 2776, 3283,  132, 1917, 1065, 1751, 3592, 1271, 4071,  860,
+    3484,  517, 3864,  195, 3633,  365, 1372, 4068,   47, 1280,  535, 1552, 2923, 1817, 2647, 2093,
+     399, 1784, 3481,  543, 3132,  735, 3496,  333, 2541, 1758,   22, 3491, 1806, 4012, 2167, 1016,
+    2322,  261, 2732, 3284,  578, 3520, 2588, 4010,   79, 2931,  670, 1057, 3096, 1942, 1487, 2711,
+    2284,  627, 1945, 3694,  397, 1785,  823, 1494, 2525, 4028, 2715, 3311,  107, 2349, 1896, 2563,
+    1198, 1956, 2378, 3200, 1678,  960, 2444,  758, 2902, 2579, 1971, 3208, 1088,  762, 3652, 1259,
+    3364,  793, 3977, 2708, 1686, 1135, 2084, 2820, 3992, 3244, 2276, 1052, 2906,  723, 2710, 1501,
+    3538, 1864,  854, 2417, 1412,  928, 3088, 1554, 1938, 3655, 3332, 2243, 4094,  565, 3651,  174,
+    3087, 3572,  246, 2512, 3119, 2277, 3510,  496, 2101, 1287,  618, 2199,  909, 3758, 1498,  235,
+    3958, 2777,  805, 1300, 2098, 3761, 3245, 1868, 3534,  926, 3941,  259, 3516, 2311,   13, 1641,
+    2805, 2279, 1329,   82, 3310, 3879,  233, 1480,  923,  488, 1418, 3836,  377, 1982, 3679,  324,
+    3124, 1232, 4081,  163, 1995, 3774,  419, 2252,  773, 1411,  328, 1765, 2794, 1312, 3294, 2054,
+    1690, 1195, 2897, 1444,  690, 1120, 2665, 3861, 3143,  269, 3460, 1587, 3063, 2641,  675, 3012,
+    1618,  391, 3549, 2940,   84, 2661,  501, 1460,  350, 2351, 1675, 2671, 1419, 3056, 4049,  966,
+    3218,  334, 1897, 2511,  912, 2248, 2944, 3650, 2429, 1925, 3049, 2529, 1647, 3216, 1171, 2456,
+     632, 2631, 1667, 3009, 3453, 2510, 1225, 2865, 3263, 2469, 3816,  932,    1, 2519, 1007,  415,
+    3910,  842, 2173, 4058, 3274, 2014,   10, 1699,  994, 2786, 1894, 3934,  329, 1126, 3383, 2157,
+    1013, 2538, 1821,  621, 3994, 1116, 2267, 3039, 3840, 1228, 3379,  603, 2127,  366, 1786, 2490,
+     634, 3841, 2919, 3691,  491, 1283, 1769,  648, 3346, 1201,  215, 3698,  877, 2344,  141, 3954,
+    1903, 3492,  434, 1108,  711, 1718,   99, 3969,  534, 1070, 1962, 3053, 3577, 1630, 2951, 2325,
+    3391, 2637,  106, 1639,  470, 3786, 2982, 1385, 2412, 3554,  800, 1332, 2464, 1964, 3701,   33,
+    3276, 3793, 1388, 3168, 1987, 1600, 3360,  819, 2083,   69, 2981,  883, 3831, 2744, 1114, 3464,
+    2024, 1454, 1019, 1645, 3467, 2730, 3160,   67, 2090, 4073, 2766,  602, 1351, 3369, 2809, 1533,
+     839, 2254, 2871, 3907, 2164, 2736, 3390, 2062, 1621, 3519, 2597,  449, 2190,  705, 3801, 1387,
+     619, 1855, 3647, 2827, 1289, 2463,  852, 3665,  510, 2049,  144, 3337, 2960,  532, 1423, 2818,
+     769, 2185,  171, 2436,  914, 3575,  218, 2817, 1759, 3606, 2523, 1980, 1379, 3556,  522, 3001,
+     116, 2401, 3268,  245, 2012,  838, 3819, 1539, 2639,  968, 1728, 3526, 2194, 1814,  507, 3635,
+    3170, 1252,   12, 1505, 3202,  506, 1338,  841, 3133,  198, 1429, 4008, 1224, 3312, 1930,  157,
+    3193, 1141, 2303,  719, 3497, 1943,  251, 1763, 3035, 4050, 2646, 1663,  918, 3871, 2384, 1753,
+     464, 2922, 1172, 3869, 2782,  552, 2549, 4052, 1391,  484, 1061, 3286,  221, 2332, 1604, 3914,
+    1276, 2819,  736, 4034, 2293,  417, 2443, 1145, 3580,  330, 2376, 3113,   54, 3873, 1018, 2013,
+     406, 2593, 3778, 1934,  979, 3565, 2584, 3883, 2257, 2842, 1888,  858, 2728,  284, 2446, 2876,
+    1571, 3933,  359, 3125, 1059, 2688, 3347, 2287,  974, 1434,  591, 2260, 3472,  237, 1098, 3500,
+    4078, 1628, 3376,  331, 1451, 2072, 1194,  743, 2366, 2937, 3866, 1812,  754, 3179, 2628,  881,
+    2152, 3695, 1772, 2690, 1402, 3044, 1820, 3238,  715, 2943, 1432,  783, 1240, 2582, 3024, 2363,
+    1436, 3424,  771, 2320, 2935,  209, 1777,  398, 1196,  698, 3710, 3228, 1665, 3872, 1023, 3585,
+     782, 2651, 1893, 1465, 4014,  423, 1526, 3832,   78, 3292, 2879, 1212, 1907, 3057, 2706, 1992,
+    2546,  893, 2359, 1842, 2967, 3732, 3115, 1717, 3325,  159, 1521, 2263, 3674, 1176, 1915,  312,
+    3436,  485, 1139,   53, 3620,  938, 3953,  139, 2123, 3888, 1795, 3279, 3735, 1664,  563, 4023,
+     169, 2783, 1655,  462, 4055, 1413, 2148, 3744, 3042, 2454,   49, 2099,  505, 1299, 2280,  409,
+    2068, 3355,   46, 2535, 2169,  668, 2868, 1148, 2477, 2011, 3612,  290, 3967,  710, 1452,   71,
+    1265, 3077,  586, 3512,  848,   35, 2291,  428, 3624,  964, 2735,  567, 2860,   29, 4051, 3045,
+    1531, 2901, 2328, 3330, 1999,  582, 2568, 1626, 1189, 2415,  422, 2714,  270, 2217,  869, 3214,
+    1906, 1063, 3697, 3158, 1113, 2467, 3315,  830, 1601, 3503, 1447, 2939, 2532, 3474, 3138, 1731,
+    3850, 1157, 2949,  896, 3716, 3209, 1975, 3525,  394, 1606,  836, 2550, 1696, 2361, 3242, 3645,
+     411, 3762, 2040, 1302, 2689, 1595, 3913, 1130, 1823, 2147, 3984, 1301, 3428, 1648, 2466,  653,
+    2074,  933, 3882, 1567, 2992, 1247, 3448, 2858, 3726,  647, 3377, 1950, 1047, 3587, 2644, 1279,
+    3537, 2233,  263, 2575, 1846,  686,   92, 2767, 1977,  521,  985, 4089, 1813,  750,  100, 2799,
+    1430,  554, 3573, 1797, 1309,  327, 1649,  799, 2679, 3937, 3163, 1142, 3737,  493,  988, 2179,
+    1548, 2603,  166, 4020, 3171,  538, 2552, 3233, 2824,  658, 2481,  362, 1991,  978, 3213, 1400,
+    3738, 2666,  363,  739, 2450,  177, 2204,  373,  951, 3011, 1311, 4002, 1536, 2972,  114, 1708,
+     594, 2867,  843, 1496, 3824, 2987, 3604, 1132, 3928, 2327, 3319,  226, 1164, 3670, 2150,  983,
+    2495, 3250, 2294,  229, 2796, 2486, 3776, 3064, 1364,  547, 2064,  234, 2760, 3378, 1853, 2880,
+     759, 3432, 1743, 1055, 2210, 1869,  875, 1435,  119, 3523, 1593, 3696, 2969, 2251,  460, 3450,
+      98, 1219, 1933, 3173, 4084, 1739, 3648, 1425, 2035, 2576,   73, 2337,  514, 2076, 3826, 2377,
+    3118, 3997, 1983, 3389,  424, 2201, 1673, 2606,  346, 1334, 2854, 2037, 2675, 1478, 3069, 3962,
+     367, 1602,  764, 3991, 3329,  987, 2048,    7, 2353, 3437, 2913, 1532, 2239, 1291,  118, 3987,
+    1217, 2326,  452, 2958, 3557,  228, 3382, 3791, 2069, 3067, 1151,  826,  142, 3959, 2717, 1736,
+    2176, 2948, 3544, 1440,  965, 2773,  546, 3106, 3947, 1714, 3547, 3136,  790, 3356, 1020,  441,
+    1469, 1152,   31, 2751,  997, 1360,  635, 3405, 1870, 3196,  662, 3749,  395, 3417,  580, 1879,
+    2896, 3643, 1940, 1229, 2174,  606, 1547, 4082, 1111, 1792,  882, 3878,  664, 3616, 2441, 3123,
+    1910, 2753, 3733,  825, 1367, 2763, 2357, 1037,  513, 1734, 2638, 3285, 1876, 1344,  661, 1092,
+    3877,  500, 2531,  250, 2301, 3420, 1187, 2500,  780,  360, 1131, 2699, 1858, 1355, 2835, 3599,
+    1931, 2599, 3690, 2286, 3184, 3973, 2455,  125, 3853,  895, 1563, 2390, 1741,  925, 2305, 1322,
+     121, 1058, 2629, 3060,  155, 3566, 3147, 2737,  339, 3632, 2492,  167, 2975, 1756,  948,  515,
+    3349,   87, 1613, 2134, 3938,  669, 1568, 2954, 4088, 2290,  253, 3754, 2373, 2915, 3532, 2473,
+    3145,  897, 1688, 3814,  687, 2043,   52, 1805, 3300, 1506, 3806, 2156,  249, 4069, 2451,  160,
+    3219,  890,  590, 1527,  317, 1835, 2822, 1097, 2106, 2963, 2625,    9, 4026, 3034, 2656, 3833,
+    3212, 2221,  471, 3897, 1712, 2434, 1251, 1905,  742, 3194, 1193, 1998, 3365, 1384, 2788, 3839,
+    1470, 1086, 3066, 2496,  297, 1887, 3290,   16, 1346, 3425,  695, 1492,  947,  352, 1775,  185,
+    1479, 2091, 2740, 3251, 1323, 3678, 2917, 3890, 2274, 2812,  613, 3387,  972, 1565,  694, 2165,
+    1661, 3950, 2908, 2032, 3479,  785, 3656, 1629, 3338,  429, 1313, 3521, 1094, 1978,  722,  433,
+    1682, 3541, 1437,  678, 2856,  921,  396, 3851, 2168, 2645, 1583, 3978,  454, 2297,  260, 2104,
+    2617, 3995,  622, 3469, 1237, 3693, 2558, 2178,  874, 2749, 1979, 3129, 4003, 2112, 3258, 3711,
+     717, 4037,  101,  991, 2418, 1608,  527,  916, 1253,  272, 1744, 2402, 2965, 3659, 2674, 3408,
+    1258,  361, 2502, 1046, 3023, 1308,  240, 2312,  682, 3790, 1900, 3167,  277, 1481, 3731, 2135,
+    2847,  969, 2527, 3435, 2067, 3741, 3000, 1421, 3361,   64,  630, 2426, 1000, 3747, 3264,  787,
+    3630,  385, 2061, 1666, 2852,  967,  544, 3898, 1703, 3637,  376, 2524, 1246,  531, 2604, 1200,
+    2292, 2873, 1836, 3605,  351, 3187, 2605, 2008, 3571, 3076, 3771, 1115,    0, 1901,  426,  944,
+    2988, 1883, 3766,  164, 2216, 4075, 2713, 3126, 1464, 2557,  961, 2256, 2800, 3375, 2514, 1264,
+      63, 4064,  337, 1616, 1208,  186, 2382, 1766,  949, 2808, 3685, 3092, 1867, 2887, 1275, 1767,
+    2983, 2400,  871, 3230,  115, 1994, 3121, 1297,  190, 2933, 1044, 1579, 3561, 2973,  829, 1693,
+    3475,  453, 1406, 3003, 2207, 1163, 4005,  153, 1543, 2499,  792, 2116, 3249, 1315, 3918, 2341,
+    3529,  738, 1424, 3206, 1681,  604, 1892, 1050, 3570,  120, 3925,  640, 1698,  378,  865, 3498,
+    1761, 3081, 2348, 3288, 2745,  815, 3551,  533, 4042, 2004, 1122, 1502,  211,  699, 2208,   24,
+    1068, 1486, 3499, 2564, 4044, 1503, 2722, 3480, 2393, 1863, 3830, 2281,   50, 1939, 3929,  213,
+    3104, 1071, 2616,  642, 3779, 1710,  755, 2764, 3444,  463, 1394, 4031, 2540,  650, 2845, 1594,
+      94, 2094, 2619, 3627,  917, 2484, 3802,  414, 2161, 1752, 2696, 1256, 3041, 4001, 2309, 2912,
+     649, 1972, 1012,  457, 3946, 1829, 3080, 1293, 2562,  271, 3501, 2288, 3297, 4025, 2595, 3394,
+    3904, 1949,  225, 1167,  697, 2295,  404, 1073,  721, 3287,  509,  898, 3440, 2781, 1382, 2435,
+    2103, 3849, 1957, 3416,   23, 2114, 3324, 1085, 2258, 1913, 3027,  194, 1685, 3456, 2052, 1129,
+    3261, 3884,  459, 1215, 2864,   26, 3320, 1341, 3018, 3427,  503, 3540, 1966, 1029, 1513,  244,
+    3818, 1319, 3618, 2192, 1377, 2504,   83, 2159, 3266, 1636,  609, 2750,  927, 1336, 1654,  489,
+     751, 2354, 3061, 3759, 1852, 3197, 3595, 2130, 3980, 1457, 2554, 3065, 1704,  425, 1026, 3614,
+     744,  338, 1508,  942, 2494, 1427, 2927,  316, 3859,  706, 3555, 2720, 1005,  450, 3709,  308,
+    2726,  873, 2380, 1948, 3131, 1619, 2058,  772, 2367,  995, 1570, 2437,   42, 3207, 2108, 2676,
+    3322, 2442,  117, 2900,  666, 3386, 1025, 3846,  832, 2953, 3926, 1937,  372, 3601, 2077, 2837,
+    1233, 3589, 1605,  446, 2798, 1350,   41, 1725, 2700,  306, 2027, 1209, 3961, 2237, 3178, 2632,
+    1788, 3272, 2746, 4090, 3146,  569, 3629, 1776, 2570, 1590, 1169, 2129, 3198, 2470, 1468, 2994,
+    1832, 1358, 3477,  248, 3945,  592, 3588, 2758, 4033,  354, 2878, 3718,  804, 3854,  593, 1175,
+    1660,  845, 3166, 1783, 3719, 1528, 2841, 1886,  364, 1393, 2362, 1168, 3135, 2448,  134, 3256,
+    2620,  268, 2145,  998, 2459, 3936,  894, 2985, 1146, 3232, 3682,  133, 2678,  691, 1522,   75,
+    3768, 1222, 2132,  232, 1850, 1268, 2316,  905, 3252,   59, 3972,  588, 1818, 3811,  778, 2244,
+    3996,  495, 2655, 1529,  943, 2431, 1204,  222, 1511, 1929, 3270, 1239, 1781, 2334, 2998, 3603,
+     379, 3932, 2085, 1161,  276, 2143,  561, 3684, 2680, 3463,   45, 3667, 1733,  827, 3795, 1519,
+    4072,  645, 3007, 3431, 1747,  596, 2241, 3638,  456, 2374,  849, 1640, 3506, 2042, 3363,  982,
+    2395,  486, 2979,  818, 3700, 2707,  183, 3783, 1356, 2803, 2268, 3415,  278, 1245, 3111,   40,
+    1076, 3331, 2107, 3714, 2843, 1799, 3459, 2158, 3649,  684, 2250,  214, 2780, 1431,  265, 1927,
+    2368, 2838,  537, 2612, 4054, 3282, 2485, 1128, 1588, 2189,  976, 2875,  559, 2718, 1988, 1015,
+    1691, 2369, 1262, 3705,  151, 2855, 3367, 1908, 1438, 4085, 1967, 2857, 1118,  472, 2920, 4019,
+    1722, 3539, 1544, 2356, 1105, 3333, 2117, 2916,  476, 1877,  770, 2955, 1637, 2615, 1981, 3578,
+    2792, 1737,  673, 1248,  112, 3222,  512, 2947, 1062, 2592, 3796,  981, 3455, 4065,  775, 3227,
+    1472,  992, 3513, 1611,  789, 1345,   95, 3050,  696, 3247, 1827, 4009, 1466, 3399,  348, 2968,
+      39, 3236, 2021,  813, 2571, 1373, 1021,  241, 2673,  656, 3120,  204, 3865, 2340, 1349,  257,
+    2731,  740, 3140, 3952,  383, 1692,  720, 1509, 3922, 2453, 1221, 3681,  971, 4086,  477, 1489,
+    2432,  281, 3114, 2264, 4015,  853, 2543, 1679,   51, 3047, 1461,  539, 2422, 2071, 1214, 2693,
+    3782,   20, 3192, 1958, 2970, 2336, 3728, 2031, 3920,  231, 2539,  401, 2339, 1184, 2170, 3562,
+     959, 3874,  447, 1632, 3985, 3210, 2059, 3753, 1709, 3404, 1236, 2501, 1562,  794, 3302, 1840,
+    2226, 1180,   93, 1926, 2635, 3617, 3079, 1036, 3443,  252, 3231, 2041,  102, 2331, 3157,  732,
+    3894,  956, 3548, 2643, 1560, 2038, 3672, 1255, 3875, 2009, 3366, 1807, 2909,  150, 3327,  508,
+    1798, 2262, 1269,  298, 3582,  518, 1774,  931, 2754, 1378, 3502,  878, 3172, 3843,  728, 2566,
+    2861, 1392, 2461, 2991,  301, 2318,  616, 2885,  908, 2232,  371, 3536, 1904, 3713, 2613,  540,
+    3887, 3423, 2872, 1383,  601, 2269,  147, 2070, 1623, 2649,  612, 1453, 2815, 3473, 1183, 1923,
+    2866, 1324, 1861,  475, 1091,  264, 3072,  576, 2304,  811,  355, 3940, 1080, 1607, 3823, 2479,
+     902, 3038, 3919, 2505, 1049, 2828, 1482, 3313,  440, 2220, 1706, 2929, 1953,  168, 1518, 1848,
+     577, 2180, 3466, 1067, 1874, 1230, 3559,   56, 3939, 1389, 2695,  614, 2986,   34, 1104, 3040,
+    1512,  924, 2110, 3687, 3229, 1165, 4059, 2832,  807, 3707, 2307, 3935,  831, 1687,  326, 3721,
+    2222,   96, 3309, 3916, 2825, 3494, 2425, 1760, 3255, 2762, 1374, 2489, 3169,  749, 2033, 1331,
+    3465,  407, 1566,  730, 2063, 4027,  148, 2385, 3817, 1119, 3654,  587, 1242, 2801, 3368, 3751,
+    3191,  109, 3805,  703, 3314, 2716, 1516, 2439, 1815, 3235, 3671,  999, 2196, 1415, 2403, 3775,
+     239, 2561,  436, 1735,  866, 2498, 1782,  502, 3186, 1250, 1822,  187, 3070, 2182, 2677,  617,
+    3025, 1582, 2392,  704, 2141, 1318,  861, 4091,  130, 1033, 3688, 2136,  242, 3581, 2755,   90,
+    2905, 2119, 3623, 2703, 3354, 1304, 2990, 1891,  708, 3075,    6, 2556, 4041, 2323,  305, 1125,
+    1721, 1307, 1955, 2506,  199, 4056,  955, 3054,  734,  322, 2046, 1599, 4040, 3221,  741, 1993,
+    1644, 3281, 3957, 2768,   15, 3789, 1408, 3514, 2175,  400, 2739, 3381, 1041, 3842, 1426, 3517,
+     900, 3785, 1153, 3190, 1720,  200, 2997, 1485, 2029, 3439, 1701,  663, 3013, 1770, 1054, 4043,
+    1651,  660, 1186,  178, 1791,  553,  950, 3545, 2686, 1352, 2128, 3396, 1553,  930, 2056, 2692,
+    3955, 2890,  856, 3100, 1614, 2122,  435, 3488, 2213, 1249, 3017,  152, 2729,  455, 3574, 2859,
+    1188, 2236,  776, 1317, 2314, 3028,  293, 2611, 1082, 3983, 1523, 2381,  558, 1974,   17, 2478,
+    1833,  285, 2770,  445, 3596, 2630, 3784,  530, 2548, 2921,  321, 3976, 1422, 2404,  431, 2202,
+    3241, 2573, 3889, 3058, 2302, 3804, 2528, 1609,  336, 3960, 1745,  765,  387, 3051, 3611,  626,
+     341, 2137, 3495,  490, 3676, 1292, 2797, 1689, 3881, 2508, 3724,  892, 2371, 1768, 1056,  111,
+    3429,  520, 2941, 3509, 1963, 1010, 3323, 1895,  746, 3112,  238, 3558, 1326, 2881, 3224, 1101,
+    3385, 2100, 3990, 1340, 1918, 1003, 2238, 3374, 1227,  788, 2338, 1123, 3298, 2684, 3760,  879,
+    1368,  287, 1932,  822, 1493, 3201,   97, 2088, 3352, 1009, 2399, 2877, 3815, 1875, 1335, 2475,
+    3182, 1545, 1149, 2698, 2347,  803, 3317,  170, 1035,  523, 1857, 3409, 1339, 3835, 2120, 2591,
+    4006, 1885, 1540,  314, 3739,  646, 1514, 3856, 2423, 1719, 2814, 2045,  834, 4060, 1668,  629,
+    2633, 1467,  779, 2410, 3099,  639, 1576,   27, 1890, 3807, 3535, 2075,   72,  726, 1941, 3030,
+    3569, 2350, 3393, 2741,  466, 1077, 3625, 1294, 2785,  550, 3226, 1244, 2205,  105, 3343,  957,
+    2329,   28, 4017, 1828,  332, 3808, 1947, 2578, 3128, 1449, 2778,  313, 3175,  631, 3006, 1456,
+     903, 2379, 3217, 1075, 2623, 2224, 2806,   81, 3478,  526, 1159, 3780, 2555,  356, 2319, 3593,
+     212, 2891, 3442,  129, 3640, 2802, 3931, 3165, 2587, 1477,  474, 2765, 1711, 3458, 1162,  173,
+    1634,  583, 1133, 1780, 4092, 2227, 2907,  763, 3905, 1969,  254, 3530,  702, 2583, 1695, 3788,
+    1951, 2957,  707, 3220, 1491, 2911, 1213,  654, 3966, 2109, 3621,  840, 2272, 1697,  205, 3727,
+     483, 2826,   65, 3862, 1638,  478, 3205,  929, 1395, 2253, 3267,  122, 1555, 3144, 1243, 1989,
+    3886, 1066, 2195, 1771, 1203,  390, 2015,  973,  283, 2974,  915, 3237, 1348, 3908, 2918, 2118,
+    3986, 2850, 3636,   38, 3117, 1550,  347, 1764, 2447, 1396, 2701, 1650, 4067, 1087, 2853,  479,
+     870, 3661, 2472, 1053, 2231,  128, 3590, 2394, 1657,   11, 1191, 2589, 4080, 1140, 2522, 3110,
+    1804, 1347, 3413, 2051, 3043, 1286, 4083, 2065, 3703, 2932,  768, 1935, 3461,  575, 2930,  824,
+    1715, 3162,  536, 4047, 2682, 2315, 1375, 3430, 2391, 4030, 1808, 2240,  295, 2419,  556, 2594,
+     835, 1327, 2468, 1996,  659, 2650, 3560, 3189,  143, 3748,  810, 2163, 3093,  217, 3407, 1409,
+    2668, 1653,  370, 3419, 3906, 1859,  876, 3350,  482, 2886, 3275, 1912,  275, 3359, 2020,  784,
+    3607, 2289,  958,  589, 2533,  267, 1803, 2659,  196, 1617, 2526, 3999, 1079, 2214, 3803, 2598,
+     335, 2389, 1507,  936, 3351,  718, 3810, 1705,  560, 1263, 3522,  752, 3677, 1034, 1535, 3384,
+    1880,  274, 3295, 1001, 3847, 1361,  885, 2151, 1166, 2888, 3433,  465, 1455, 1866, 2285, 3942,
+     162, 3153, 2018, 1321,  573, 3068, 2681, 1403, 2172, 3675,  671, 1510, 2811,  579, 3813, 1241,
+     149, 2669, 3981, 1865, 3680,  816, 3485, 1138,  628, 3392, 1298,  375, 2821, 1670,   80, 1404,
+    3342, 3764, 2789,   62, 1881, 3019,  191, 2702, 2133, 2895,  175, 2634, 3097, 1830, 3829,  386,
+    3016, 3743, 1556, 2184, 3005,  380, 2545, 4011,  566, 1801, 2386, 1030, 3827, 2565,  693, 1174,
+    2188, 3524,  935, 2846, 2308, 1603,  227, 4024, 1024, 1790, 2411, 3915,  977, 2259, 1610, 2889,
+    3257, 1558,  318, 1223, 3151, 1504, 2956, 2317, 3921, 2006, 3107, 2427,  889, 3584, 3122, 2139,
+     643, 1093, 2039, 3576, 2518, 1573, 1160, 3564,  844, 3307, 1615, 1179, 2115,    3, 2738, 1273,
+    2105,  636, 2727,  179, 3515, 1624, 1944, 3296, 1475, 3668,    8, 2810, 3239,  294, 3622, 2925,
+     473, 1561, 4061,   48, 3702, 1081, 3203, 2542,  344, 3086, 1282,   91, 3031, 3490,  368, 2445,
+     689, 2111, 3380, 2742, 2198,    5, 1909,  430, 2790,  809,  230, 3858, 1878,  548, 1210, 4022,
+    1755, 2950,  374, 1303, 3923,  504, 3185, 1922,  323, 3792, 2438,  549, 4007, 3243,  867, 3583,
+    2537,  975, 4045, 1261, 2375,  761, 2840,  256,  952, 3091, 2016, 1234, 1674,  837, 1946, 1398,
+    3085, 2398,  677, 2663, 1789, 3451,  745, 1919, 3723,  615, 3531, 2648, 2007, 1342, 1811, 4016,
+    1127, 3715,  913,  557, 3892, 1060, 3708, 3280, 1199, 1740, 3511, 1445, 2203, 3026, 2624,  319,
+    2330, 3468,  812, 3223, 2235,  970, 2462, 4070, 1353, 2036,  989, 2980, 1724, 1397, 2360,  451,
+    1577, 3418, 1916,  541, 3105, 3712, 1192, 3899, 2265, 2654,  676, 3988, 2342, 3398, 2626, 3900,
+    1004, 1871, 3340, 1366, 2186,  439, 2428, 1495, 2816, 2247, 1643,  862, 3781,  570, 3291,  108,
+    2999, 1924, 2574, 1671, 3073, 2476,  747, 1575, 2622, 2261, 2924, 1089,  113, 3402, 1584, 1006,
+    3673, 1476, 2748, 1844,  296, 2971, 1729,  623, 2662, 3094,  158, 3602, 2694,  280, 3885, 1968,
+    3036,   77, 2869, 1490, 2087,  154, 2601, 1702,  480, 3278, 1586,  223, 3033,  498, 1150,  140,
+    3462, 2772,  289,  922, 3837, 2928, 1257, 3956,  197, 1112, 3373,  388, 2553, 1069, 2124, 2503,
+    1515,  442, 3553,  184, 1371, 2047, 3476,  201, 4053,  402,  655, 3787, 2405,  814, 3848, 1965,
+       2, 2516,  551, 3855, 1416, 3653,   57, 3411, 1103, 3745, 1802,  733, 2225, 1048, 3336,  688,
+    3757, 1107, 2406, 3912, 3328,  934, 3504, 2155, 1330, 3799,  993, 3493, 2144, 1450, 3734, 2089,
+     574, 1538, 3686, 3127, 1700,   88, 3508,  850, 3211, 2053, 2952, 4066, 1762, 3164, 3683,  808,
+    3867, 1177, 2752, 2212, 3971,  499, 2831, 1898, 1027, 3130, 2023, 3273, 1748, 2769,  528, 2942,
+    3289, 1190, 2131, 3397, 1042, 2627, 2282, 1520, 2095,  468, 2424, 1305, 3154, 1677, 2795, 1357,
+    2577, 1810,  802,  343, 1369, 1838,  599, 3149,   76, 2421, 1809, 2709,  731, 2899, 1727, 2547,
+    3948, 2211, 1216, 2449,  641, 2697, 2138, 1591, 2521,  637, 1310,   55, 2310, 1420,  288, 2936,
+    1973, 3414,  657, 3142,  907, 1231, 3262, 1443, 3639, 2364, 1530, 1202,  302, 3600, 2153, 1410,
+    4062,  786, 2892,  176, 2017,  724, 3109, 3911,  846, 3301, 2882, 3989,   61, 3664,  481, 2146,
+     224, 3552, 3225, 2724, 2255, 2977, 4039, 1102, 2787, 3608,  410, 1278, 4076,   44, 3176,  855,
+     392, 2903,  145, 2001, 4046, 1144, 3348,  266, 3893, 1841, 2685, 3410,  886, 2829,  625, 1658,
+    2420,   36, 1488, 1856, 3657, 2346,   74, 2653,  795,  258, 2734, 3993,  851, 2515, 1106,  203,
+    1837, 2387, 1578, 3159, 3974, 1757,  403, 1218, 2721,  192, 1572,  946, 2003, 2471, 1011, 4074,
+    3022, 1534, 1156,  524, 3663,  210, 2440, 1592, 2025,  833, 3021, 1960, 2352, 1084, 3662, 1381,
+    1773, 3277, 3609,  899, 3102, 1849,  545, 2966,  986, 3550,  437, 1622, 3924, 2086, 3579, 3259,
+    1039, 4035, 3010, 2664,  357, 1627, 3445, 2097, 3852, 3020,  581, 1882, 3452, 1559, 3155, 3722,
+    2712,  427, 3669,  610, 1354, 2791, 3594, 2396, 1847, 3828, 2270, 3527,  595, 3240, 2863, 1872,
+     712, 2345, 3870, 2102, 1723, 1238,  757, 3372,  311, 3927, 1483, 3482,  611, 2830, 2066, 2483,
+     727, 1147, 2621, 1546,  309, 2567, 3644, 2298, 1386, 2073, 3071, 1121, 2491,  156, 1281, 2640,
+     467, 2242, 1266,  791, 3917, 2551,  624, 1083, 1794, 1376, 3326, 2278,   70, 2839,  665, 2230,
+     962, 3421, 1220, 2596, 2218,  945,  255, 3339,  700, 1363,  393, 2670, 1158, 1596,  279, 1316,
+    3370,   25, 2904,  904, 3139, 2590, 3844, 2884, 2283, 1074, 2580,  165, 3234, 1569,  307, 3447
+};
+
+static const dither_mask_t s_blue_noise_64x64
+{
+    64, s_blue_noise_64x64_ranks
+};
+
+const dither_mask_t& get_blue_noise_mask()
+{
+    return s_blue_noise_64x64;
+}
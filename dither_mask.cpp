@@ -0,0 +1,53 @@
+#include "dither_mask.h"
+#include <array>
+
+// Every matrix is built from the one half its size:
+// M(2n) = | 4 M(n)      4 M(n) + 2 |
+//         | 4 M(n) + 3  4 M(n) + 1 |
+template <int size>
+static constexpr std::array<uint16_t, size * size> bayer_ranks()
+{
+    std::array<uint16_t, size * size> ranks = {};
+
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            // Finest quadrant first, coarsest one ends up least significant
+            int rank = 0;
+            for (int bit = 1; bit < size; bit *= 2)
+            {
+                const auto right = (x & bit) != 0;
+                const auto down  = (y & bit) != 0;
+
+                rank = rank * 4 + (down ? (right ? 1 : 3) : (right ? 2 : 0));
+            }
+
+            ranks[x + y * size] = static_cast<uint16_t>(rank);
+        }
+    }
+
+    return ranks;
+}
+
+static constexpr auto s_bayer_2_ranks  = bayer_ranks<2>();
+static constexpr auto s_bayer_4_ranks  = bayer_ranks<4>();
+static constexpr auto s_bayer_8_ranks  = bayer_ranks<8>();
+static constexpr auto s_bayer_16_ranks = bayer_ranks<16>();
+
+static const dither_mask_t s_bayer_masks[] =
+{
+    {  2, s_bayer_2_ranks.data()  },
+    {  4, s_bayer_4_ranks.data()  },
+    {  8, s_bayer_8_ranks.data()  },
+    { 16, s_bayer_16_ranks.data() }
+};
+
+const dither_mask_t& get_bayer_mask(int size)
+{
+    for (auto& mask : s_bayer_masks)
+        if (size <= mask.size)
+            return mask;
+
+    return s_bayer_masks[3];
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+// Threshold matrix of ordered dithering, repeated over the whole grid. Holds
+// rank of every position, 0 .. size * size - 1, position with lower rank is
+// rounded up to the next palette level first.
+struct dither_mask_t
+{
+    int             size;
+    const uint16_t* ranks;
+};
+
+// Bayer matrix of 'size' 2, 4, 8 or 16, other sizes round up to the next one,
+// 16 at most.
+const dither_mask_t& get_bayer_mask(int size);
+
+// 64x64 blue noise, tileable.
+const dither_mask_t& get_blue_noise_mask();
@@ -1,554 +1,348 @@
 #include "drawing.h"
+#include "simd.h"
 #include <algorithm>
+#include <cstring>
 
-using std::min;
-using std::max;
-template <typename T> static inline T min(T a, T b, T c) { return std::min(a, std::min(b, c)); }
-template <typename T> static inline T max(T a, T b, T c) { return std::max(a, std::max(b, c)); }
-
+// Virtual path, primitives instantiated for framebuffer_t itself.
 void generic_fill_rect_2d(framebuffer_t& buffer, int x0, int y0, int x1, int y1, float color)
 {
-    if (x0 > x1) std::swap(x0, x1);
-    if (y0 > y1) std::swap(y0, y1);
-
-    for (int y = y0; y < y1; ++y)
-    {
-        for (int x = x0; x < x1; ++x)
-        {
-            buffer.set(x, y, color);
-        }
-    }
+    generic_fill_rect_2d<framebuffer_t>(buffer, x0, y0, x1, y1, color);
 }
 
-// http://www.codecodex.com/wiki/Bresenham's_line_algorithm
 void generic_circle_2d(framebuffer_t& buffer, int cx, int cy, int radius, float color)
 {
-    int f     = 1 - radius;
-    int ddF_x = 0;
-    int ddF_y = -2 * radius;
-    int x     = 0;
-    int y     = radius;
-
-    buffer.set(cx, cy + radius, color);
-    buffer.set(cx, cy - radius, color);
-    buffer.set(cx + radius, cy, color);
-    buffer.set(cx - radius, cy, color);
-
-    while (x < y)
-    {
-        if (f >= 0)
-        {
-            y--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        x++;
-        ddF_x += 2;
-        f += ddF_x + 1;
-        buffer.set(cx + x, cy + y, color);
-        buffer.set(cx - x, cy + y, color);
-        buffer.set(cx + x, cy - y, color);
-        buffer.set(cx - x, cy - y, color);
-        buffer.set(cx + y, cy + x, color);
-        buffer.set(cx - y, cy + x, color);
-        buffer.set(cx + y, cy - x, color);
-        buffer.set(cx - y, cy - x, color);
-    }
+    generic_circle_2d<framebuffer_t>(buffer, cx, cy, radius, color);
 }
 
-// https://sites.google.com/site/ruslancray/lab/projects/bresenhamscircleellipsedrawingalgorithm/bresenham-s-circle-ellipse-drawing-algorithm
 void generic_ellipse_2d(framebuffer_t& buffer, int cx, int cy, int rx, int ry, float color)
 {
-    const auto a2  = rx * rx;
-    const auto b2  = ry * ry;
-    const auto fa2 = 4 * a2;
-    const auto fb2 = 4 * b2;
-
-    for (int x = 0, y = ry, sigma = 2 * b2 + a2 * (1 - 2 * ry); b2 * x <= a2 * y; x++)
-    {
-        buffer.set(cx + x, cy + y, color);
-        buffer.set(cx - x, cy + y, color);
-        buffer.set(cx + x, cy - y, color);
-        buffer.set(cx - x, cy - y, color);
-        if (sigma >= 0)
-        {
-            sigma += fa2 * (1 - y);
-            y--;
-        }
-        sigma += b2 * ((4 * x) + 6);
-    }
-
-    for (int x = rx, y = 0, sigma = 2 * a2 + b2 * (1 - 2 * rx); a2 * y <= b2 * x; y++)
-    {
-        buffer.set(cx + x, cy + y, color);
-        buffer.set(cx - x, cy + y, color);
-        buffer.set(cx + x, cy - y, color);
-        buffer.set(cx - x, cy - y, color);
-        if (sigma >= 0)
-        {
-            sigma += fb2 * (1 - x);
-            x--;
-        }
-        sigma += a2 * ((4 * y) + 6);
-    }
+    generic_ellipse_2d<framebuffer_t>(buffer, cx, cy, rx, ry, color);
 }
 
-// http://www.roguebasin.com/index.php?title=Bresenham%27s_Line_Algorithm#C.2B.2B
 void generic_line_2d(framebuffer_t& buffer, int x0, int y0, int x1, int y1, float color)
 {
-    const auto flip = abs(y1 - y0) > abs(x1 - x0);
-    if (flip)
-    {
-        std::swap(x0, y0);
-        std::swap(x1, y1);
-    }
-
-    if (x0 > x1)
-    {
-        std::swap(x0, x1);
-        std::swap(y0, y1);
-    }
+    generic_line_2d<framebuffer_t>(buffer, x0, y0, x1, y1, color);
+}
 
-    const auto dx   = x1 - x0;
-    const auto dy   = abs(y1 - y0);
-    const auto step = y0 < y1 ? 1 : -1;
+void generic_hline_2d(framebuffer_t& buffer, int x1, int y, int x2, float c)
+{
+    generic_hline_2d<framebuffer_t>(buffer, x1, y, x2, c);
+}
 
-    auto error = dx / 2;
-    auto y = y0;
+void generic_vline_2d(framebuffer_t& buffer, int x, int y1, int y2, float c)
+{
+    generic_vline_2d<framebuffer_t>(buffer, x, y1, y2, c);
+}
 
-    for (int x = x0; x < x1; ++x)
-    {
-        if (flip)
-            buffer.set(y, x, color);
-        else
-            buffer.set(x, y, color);
+void generic_triangle_2d(framebuffer_t& buffer, int x0, int y0, int x1, int y1, int x2, int y2, float color)
+{
+    generic_triangle_2d<framebuffer_t>(buffer, x0, y0, x1, y1, x2, y2, color);
+}
 
-        error = error - dy;
-        if (error < 0)
-        {
-            y     += step;
-            error += dx;
-        }
-    }
+void generic_triangle_2d(framebuffer_t& buffer, const image_t& texture, float x0, float y0, float x1, float y1, float x2, float y2, float u0, float v0, float u1, float v1, float u2, float v2, float c0, float c1, float c2, float a0, float a1, float a2)
+{
+    generic_triangle_2d<framebuffer_t>(buffer, texture, x0, y0, x1, y1, x2, y2, u0, v0, u1, v1, u2, v2, c0, c1, c2, a0, a1, a2);
 }
 
-void generic_hline_2d(framebuffer_t& buffer, int x1, int y, int x2, float c)
+void generic_char_2d(framebuffer_t& buffer, const font_t& font, int x, int y, char c, float color)
 {
-    if (x1 > x2)
-        std::swap(x1, x2);
+    generic_char_2d<framebuffer_t>(buffer, font, x, y, c, color);
+}
 
-    for (int x = x1; x < x2; ++x)
-        buffer.set(x, y, c);
+void generic_triangle_3d(framebuffer_t& buffer,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2,
+    float c0, float c1, float c2)
+{
+    generic_triangle_3d<framebuffer_t>(buffer,
+        x0, y0, z0,
+        x1, y1, z1,
+        x2, y2, z2,
+        c0, c1, c2);
 }
 
-void generic_vline_2d(framebuffer_t& buffer, int x, int y1, int y2, float c)
+void generic_triangle_3d(framebuffer_t& buffer, const rect_t& scissor,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2,
+    float c0, float c1, float c2)
 {
-    if (y1 > y2)
-        std::swap(y1, y2);
+    generic_triangle_3d<framebuffer_t>(buffer, scissor,
+        x0, y0, z0,
+        x1, y1, z1,
+        x2, y2, z2,
+        c0, c1, c2);
+}
 
-    for (int y = y1; y < y2; ++y)
-        buffer.set(x, y, c);
+void generic_line_3d(framebuffer_t& buffer,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float c0, float c1)
+{
+    generic_line_3d<framebuffer_t>(buffer,
+        x0, y0, z0,
+        x1, y1, z1,
+        c0, c1);
 }
 
-// http://forum.devmaster.net/t/advanced-rasterization/6145
-void generic_triangle_2d(framebuffer_t& buffer, int x0, int y0, int x1, int y1, int x2, int y2, float color)
+bool framebuffer_t::depth_occluded(int x0, int y0, int x1, int y1, float z) const
 {
-    // 28.4 fixed-point coordinates
-    const int Y0 = y0 << 4;
-    const int Y1 = y1 << 4;
-    const int Y2 = y2 << 4;
-
-    const int X0 = x0 << 4;
-    const int X1 = x1 << 4;
-    const int X2 = x2 << 4;
-
-    // Deltas
-    const int DX01 = X0 - X1;
-    const int DX12 = X1 - X2;
-    const int DX20 = X2 - X0;
-
-    const int DY01 = Y0 - Y1;
-    const int DY12 = Y1 - Y2;
-    const int DY20 = Y2 - Y0;
-
-    // Fixed-point deltas
-    const int FDX01 = DX01 << 4;
-    const int FDX12 = DX12 << 4;
-    const int FDX20 = DX20 << 4;
-
-    const int FDY01 = DY01 << 4;
-    const int FDY12 = DY12 << 4;
-    const int FDY20 = DY20 << 4;
-
-    // Bounding rectangle
-    int minx = (min(X0, X1, X2) + 0x0F) >> 4;
-    int maxx = (max(X0, X1, X2) + 0x0F) >> 4;
-    int miny = (min(Y0, Y1, Y2) + 0x0F) >> 4;
-    int maxy = (max(Y0, Y1, Y2) + 0x0F) >> 4;
-
-    // Half-edge constants
-    int C0 = DY01 * X0 - DX01 * Y0;
-    int C1 = DY12 * X1 - DX12 * Y1;
-    int C2 = DY20 * X2 - DX20 * Y2;
-
-    // Correct for fill convention
-    if (DY01 < 0 || (DY01 == 0 && DX01 > 0)) C0++;
-    if (DY12 < 0 || (DY12 == 0 && DX12 > 0)) C1++;
-    if (DY20 < 0 || (DY20 == 0 && DX20 > 0)) C2++;
-
-    int CY0 = C0 + DX01 * (miny << 4) - DY01 * (minx << 4);
-    int CY1 = C1 + DX12 * (miny << 4) - DY12 * (minx << 4);
-    int CY2 = C2 + DX20 * (miny << 4) - DY20 * (minx << 4);
-
-    for (int y = miny; y < maxy; y++)
+    for (int ty = y0 / depth_tile_size; ty <= (y1 - 1) / depth_tile_size; ++ty)
     {
-        int CX0 = CY0;
-        int CX1 = CY1;
-        int CX2 = CY2;
+        auto tile = depth_tiles.data() + ty * depth_tiles_x;
 
-        for (int x = minx; x < maxx; x++)
+        for (int tx = x0 / depth_tile_size; tx <= (x1 - 1) / depth_tile_size; ++tx)
         {
-            if (CX0 > 0 && CX1 > 0 && CX2 > 0)
-            {
-                buffer.set(x, y, color);
-            }
-
-            CX0 -= FDY01;
-            CX1 -= FDY12;
-            CX2 -= FDY20;
+            if (!(z > tile[tx]))
+                return false;
         }
-
-        CY0 += FDX01;
-        CY1 += FDX12;
-        CY2 += FDX20;
     }
+
+    return true;
 }
 
-void generic_triangle_2d(framebuffer_t& buffer, const image_t& texture, float x0, float y0, float x1, float y1, float x2, float y2, float u0, float v0, float u1, float v1, float u2, float v2, float c0, float c1, float c2, float a0, float a1, float a2)
+void framebuffer_t::update_depth_tile(int tile_x, int tile_y)
 {
-    // 24.8 fixed-point
-    const int precission = 4;
-    const int mask       = (1 << precission) - 1;
-
-    // Fixed-point coordinates
-    const int Y0 = (int)(y0 * static_cast<float>(1 << precission));
-    const int Y1 = (int)(y1 * static_cast<float>(1 << precission));
-    const int Y2 = (int)(y2 * static_cast<float>(1 << precission));
-
-    const int X0 = (int)(x0 * static_cast<float>(1 << precission));
-    const int X1 = (int)(x1 * static_cast<float>(1 << precission));
-    const int X2 = (int)(x2 * static_cast<float>(1 << precission));
-
-    // Deltas
-    const int DX01 = X0 - X1;
-    const int DX12 = X1 - X2;
-    const int DX20 = X2 - X0;
-
-    const int DY01 = Y0 - Y1;
-    const int DY12 = Y1 - Y2;
-    const int DY20 = Y2 - Y0;
-
-    // Fixed-point deltas
-    const int FDX01 = DX01 << precission;
-    const int FDX12 = DX12 << precission;
-    const int FDX20 = DX20 << precission;
-
-    const int FDY01 = DY01 << precission;
-    const int FDY12 = DY12 << precission;
-    const int FDY20 = DY20 << precission;
-
-    // Bounding rectangle
-    int minx = (min(X0, X1, X2) + mask) >> precission;
-    int maxx = (max(X0, X1, X2) + mask) >> precission;
-    int miny = (min(Y0, Y1, Y2) + mask) >> precission;
-    int maxy = (max(Y0, Y1, Y2) + mask) >> precission;
-
-    // Half-edge constants
-    int C0 = DY01 * X0 - DX01 * Y0;
-    int C1 = DY12 * X1 - DX12 * Y1;
-    int C2 = DY20 * X2 - DX20 * Y2;
-
-    // Correct for fill convention
-    if (DY01 < 0 || (DY01 == 0 && DX01 > 0)) C0++;
-    if (DY12 < 0 || (DY12 == 0 && DX12 > 0)) C1++;
-    if (DY20 < 0 || (DY20 == 0 && DX20 > 0)) C2++;
-
-    int CY0 = C0 + DX01 * (miny << precission) - DY01 * (minx << precission);
-    int CY1 = C1 + DX12 * (miny << precission) - DY12 * (minx << precission);
-    int CY2 = C2 + DX20 * (miny << precission) - DY20 * (minx << precission);
-
-    auto iC = 1.0f / (CY0 + CY1 + CY2);
-
-    for (int y = miny; y < maxy; y++)
+    const int x0 = tile_x * depth_tile_size;
+    const int y0 = tile_y * depth_tile_size;
+    const int x1 = std::min(x0 + depth_tile_size, width);
+    const int y1 = std::min(y0 + depth_tile_size, height);
+
+    depth_tiles[tile_x + tile_y * depth_tiles_x] = with_depth([&](auto format, auto data)
     {
-        if (y >= 0 && y < buffer.height)
+        auto farthest = data[x0 + y0 * width];
+        for (int y = y0; y < y1; ++y)
         {
-            int CX0 = CY0;
-            int CX1 = CY1;
-            int CX2 = CY2;
+            auto row = data + y * width;
 
-            for (int x = minx; x < maxx; x++)
-            {
-                if (x >= 0 && x < buffer.width)
-                {
-                    if (CX0 > 0 && CX1 > 0 && CX2 > 0)
-                    {
-                        const auto c = (c2 * CX0 + c0 * CX1 + c1 * CX2) * iC;
-                        const auto a = (a2 * CX0 + a0 * CX1 + a1 * CX2) * iC;
-                        const auto u = (u2 * CX0 + u0 * CX1 + u1 * CX2) * iC;
-                        const auto v = (v2 * CX0 + v0 * CX1 + v1 * CX2) * iC;
-
-                        const auto tx = std::max(0, std::min(static_cast<int>(u * (texture.width)), texture.width - 1));
-                        const auto ty = std::max(0, std::min(static_cast<int>(v * (texture.height)), texture.height - 1));
-
-                        const auto texture_color = texture.data[tx + ty * texture.pitch] * (1.0f / 255.0f);
-
-                        buffer.blend(x, y, c, texture_color * a);
-                    }
-                }
-                else if (x >= buffer.width)
-                    break;
-
-                CX0 -= FDY01;
-                CX1 -= FDY12;
-                CX2 -= FDY20;
-            }
+            for (int x = x0; x < x1; ++x)
+                farthest = std::max(farthest, row[x]);
         }
-        else if (y >= buffer.height)
-            return;
 
-        CY0 += FDX01;
-        CY1 += FDX12;
-        CY2 += FDX20;
+        return format.upper_bound(farthest);
+    });
+}
+
+void framebuffer_t::defer_clear(unsigned flags, float c, float d)
+{
+    for (auto& tile : tile_clears)
+        tile |= flags;
+
+    if (flags & clear_color_flag)
+    {
+        // Drawn tiles go back to clear color, all of them if color changes
+        const auto changed = c != deferred_color;
+        for (auto& tile : tile_dirty)
+        {
+            if (changed || (tile & dirty_drawn))
+                tile = dirty_written;
+        }
+
+        deferred_color = c;
     }
+
+    if (flags & clear_depth_flag)
+        deferred_depth = d;
+
+    clears_deferred = true;
 }
 
-void generic_char_2d(framebuffer_t& buffer, const font_t& font, int x, int y, char c, float color)
+void framebuffer_t::resolve_clears()
 {
-    auto data = font.find(c);
-    if (!data)
+    if (!clears_deferred)
         return;
 
-    if (font.pack == font_pack_row_low)
+    const int tiles_y = static_cast<int>(tile_clears.size()) / depth_tiles_x;
+
+    // Consecutive tile rows missing the same clear are filled as one band of
+    // whole rows with streaming stores, leftovers are cleared tile by tile.
+    int      band_start = 0;
+    unsigned band_flags = 0;
+
+    const auto fill_band = [&](int band_end)
     {
-        for (int cx = 0; cx < font.w; ++cx)
-        {
-            auto rows = data[cx];
+        const int y0 = band_start * depth_tile_size;
+        const int y1 = std::min(band_end * depth_tile_size, height);
 
-            for (int cy = 0; cy < font.h; ++cy)
+        if (band_flags & clear_depth_flag)
+        {
+            with_depth([&](auto format, auto data)
             {
-                buffer.set(x + cx, y + cy, rows & (1 << cy) ? color : 0);
-            }
+                stream_fill(data + y0 * width, static_cast<size_t>(y1 - y0) * width, format.encode(deferred_depth));
+            });
         }
-    }
-    else if (font.pack == font_pack_row_high)
+
+        if (band_flags & clear_color_flag)
+            clear_color(y0, y1, deferred_color);
+    };
+
+    for (int ty = 0; ty < tiles_y; ++ty)
     {
-        for (int cx = 0; cx < font.w; ++cx)
+        const auto row = tile_clears.data() + ty * depth_tiles_x;
+
+        unsigned row_flags = clear_color_flag | clear_depth_flag;
+        for (int tx = 0; tx < depth_tiles_x; ++tx)
+            row_flags &= row[tx];
+
+        if (row_flags != band_flags)
         {
-            auto rows = data[cx];
+            fill_band(ty);
 
-            for (int cy = 0; cy < font.h; ++cy)
-            {
-                buffer.set(x + cx, y + cy, rows & (1 << (7 - cy)) ? color : 0);
-            }
+            band_start = ty;
+            band_flags = row_flags;
         }
-    }
-    else if (font.pack == font_pack_column_low)
-    {
-        for (int cy = 0; cy < font.h; ++cy)
+
+        for (int tx = 0; tx < depth_tiles_x; ++tx)
         {
-            auto column = data[cy];
+            if (row[tx] & ~row_flags)
+                resolve_clear_tile(tx, ty, row[tx] & ~row_flags);
 
-            for (int cx = 0; cx < font.w; ++cx)
-            {
-                buffer.set(x + cx, y + cy, column & (1 << cx) ? color : 0);
-            }
+            row[tx] = 0;
         }
     }
-    else if (font.pack == font_pack_column_high)
+
+    fill_band(tiles_y);
+
+    clears_deferred = false;
+}
+
+void framebuffer_t::resolve_clears(int x0, int y0, int x1, int y1)
+{
+    const int tx0 = std::max(x0, 0) / depth_tile_size;
+    const int ty0 = std::max(y0, 0) / depth_tile_size;
+    const int tx1 = (std::min(x1, width)  - 1) / depth_tile_size;
+    const int ty1 = (std::min(y1, height) - 1) / depth_tile_size;
+
+    for (int ty = ty0; ty <= ty1; ++ty)
     {
-        for (int cy = 0; cy < font.h; ++cy)
-        {
-            auto column = data[cy];
+        const auto row = tile_clears.data() + ty * depth_tiles_x;
 
-            for (int cx = 0; cx < font.w; ++cx)
+        for (int tx = tx0; tx <= tx1; ++tx)
+        {
+            if (row[tx])
             {
-                buffer.set(x + cx, y + cy, column & (1 << (7 - cx)) ? color : 0);
+                resolve_clear_tile(tx, ty, row[tx]);
+                row[tx] = 0;
             }
         }
     }
 }
 
-// http://forum.devmaster.net/t/advanced-rasterization/6145
-void generic_triangle_3d(framebuffer_t& buffer,
-    float x0, float y0, float z0,
-    float x1, float y1, float z1,
-    float x2, float y2, float z2,
-    float c0, float c1, float c2)
+void framebuffer_t::resolve_clear_tile(int tile_x, int tile_y, unsigned flags)
 {
-    // 28.4 fixed-point coordinates
-    const int Y0 = (int)(y0 * 16.0f);
-    const int Y1 = (int)(y1 * 16.0f);
-    const int Y2 = (int)(y2 * 16.0f);
-
-    const int X0 = (int)(x0 * 16.0f);
-    const int X1 = (int)(x1 * 16.0f);
-    const int X2 = (int)(x2 * 16.0f);
-
-    // Deltas
-    const int DX01 = X0 - X1;
-    const int DX12 = X1 - X2;
-    const int DX20 = X2 - X0;
-
-    const int DY01 = Y0 - Y1;
-    const int DY12 = Y1 - Y2;
-    const int DY20 = Y2 - Y0;
-
-    // Fixed-point deltas
-    const int FDX01 = DX01 << 4;
-    const int FDX12 = DX12 << 4;
-    const int FDX20 = DX20 << 4;
-
-    const int FDY01 = DY01 << 4;
-    const int FDY12 = DY12 << 4;
-    const int FDY20 = DY20 << 4;
-
-    // Bounding rectangle
-    int minx = (min(X0, X1, X2) + 0x0F) >> 4;
-    int maxx = (max(X0, X1, X2) + 0x0F) >> 4;
-    int miny = (min(Y0, Y1, Y2) + 0x0F) >> 4;
-    int maxy = (max(Y0, Y1, Y2) + 0x0F) >> 4;
-
-    if (minx >= buffer.width  || maxx < 0) return;
-    if (miny >= buffer.height || maxy < 0) return;
-
-    // Half-edge constants
-    int C0 = DY01 * X0 - DX01 * Y0;
-    int C1 = DY12 * X1 - DX12 * Y1;
-    int C2 = DY20 * X2 - DX20 * Y2;
-
-    // Correct for fill convention
-    if (DY01 < 0 || (DY01 == 0 && DX01 > 0)) C0++;
-    if (DY12 < 0 || (DY12 == 0 && DX12 > 0)) C1++;
-    if (DY20 < 0 || (DY20 == 0 && DX20 > 0)) C2++;
-
-    int CY0 = C0 + DX01 * (miny << 4) - DY01 * (minx << 4);
-    int CY1 = C1 + DX12 * (miny << 4) - DY12 * (minx << 4);
-    int CY2 = C2 + DX20 * (miny << 4) - DY20 * (minx << 4);
-
-    if (miny < 0)
+    const int x0 = tile_x * depth_tile_size;
+    const int y0 = tile_y * depth_tile_size;
+    const int x1 = std::min(x0 + depth_tile_size, width);
+    const int y1 = std::min(y0 + depth_tile_size, height);
+
+    if (flags & clear_depth_flag)
     {
-        auto diff = -miny;
-        CY0 += FDX01 * diff;
-        CY1 += FDX12 * diff;
-        CY2 += FDX20 * diff;
-        miny = 0;
+        with_depth([&](auto format, auto data)
+        {
+            const auto value = format.encode(deferred_depth);
+
+            for (int y = y0; y < y1; ++y)
+                std::fill(data + x0 + y * width, data + x1 + y * width, value);
+        });
     }
 
-    if (maxy >= buffer.height)
-        maxy = buffer.height - 1;
+    if (flags & clear_color_flag)
+    {
+        for (int y = y0; y < y1; ++y)
+            fill_color_span(x0, y, x1 - x0, deferred_color);
+    }
+}
 
-    const auto offset_x = (minx < 0) ? -minx : 0;
-    if (offset_x)
-        minx = 0;
+void framebuffer_t::collect_dirty_rects()
+{
+    dirty_rects.clear();
+    dirty_bounds = { width, height, 0, 0 };
 
-    const auto C  = CY0 + CY1 + CY2;
-    if (C == 0)
-        return;
+    const int tiles_y = static_cast<int>(tile_dirty.size()) / depth_tiles_x;
 
-    const auto iC  = 1.0f / C;
-    const auto iZ0 = 1.0f / z0;
-    const auto iZ1 = 1.0f / z1;
-    const auto iZ2 = 1.0f / z2;
+    // Runs of dirty tiles in a row extend rectangle of the same run above.
+    // 'open' holds rectangles reaching previous row, ordered by x.
+    std::vector<int> open, next;
 
-    for (int y = miny; y < maxy; y++)
+    for (int ty = 0; ty < tiles_y; ++ty)
     {
-        int CX0 = CY0 - FDY01 * offset_x;
-        int CX1 = CY1 - FDY12 * offset_x;
-        int CX2 = CY2 - FDY20 * offset_x;
+        const auto row = tile_dirty.data() + ty * depth_tiles_x;
+        const int  y0  = ty * depth_tile_size;
+        const int  y1  = std::min(y0 + depth_tile_size, height);
+
+        size_t above = 0;
+        next.clear();
 
-    //#pragma omp parallel for
-        for (int x = minx; x < maxx; x++)
+        for (int tx = 0; tx < depth_tiles_x; )
         {
+            if (!(row[tx] & dirty_written))
             {
-                if (CX0 > 0 && CX1 > 0 && CX2 > 0)
-                {
-                    auto c =         (c2  * CX0 + c0  * CX1 + c1  * CX2) * iC;
-                    auto z = 1.0f / ((iZ2 * CX0 + iZ0 * CX1 + iZ1 * CX2) * iC);
-
-                    if (z >= 0.0f && z <= 1.0f)
-                        buffer.set(x, y, z, c);
-                }
+                ++tx;
+                continue;
             }
 
-            CX0 -= FDY01;
-            CX1 -= FDY12;
-            CX2 -= FDY20;
+            const int start = tx;
+            for (; tx < depth_tiles_x && (row[tx] & dirty_written); ++tx)
+                row[tx] &= ~dirty_written;
+
+            const int x0 = start * depth_tile_size;
+            const int x1 = std::min(tx * depth_tile_size, width);
+
+            while (above < open.size() && dirty_rects[open[above]].x0 < x0)
+                ++above;
+
+            if (above < open.size() && dirty_rects[open[above]].x0 == x0 && dirty_rects[open[above]].x1 == x1)
+            {
+                dirty_rects[open[above]].y1 = y1;
+                next.push_back(open[above++]);
+            }
+            else
+            {
+                next.push_back(static_cast<int>(dirty_rects.size()));
+                dirty_rects.push_back({ x0, y0, x1, y1 });
+            }
+
+            dirty_bounds.x0 = std::min(dirty_bounds.x0, x0);
+            dirty_bounds.y0 = std::min(dirty_bounds.y0, y0);
+            dirty_bounds.x1 = std::max(dirty_bounds.x1, x1);
+            dirty_bounds.y1 = std::max(dirty_bounds.y1, y1);
         }
 
-        CY0 += FDX01;
-        CY1 += FDX12;
-        CY2 += FDX20;
+        open.swap(next);
     }
 }
 
-void generic_line_3d(framebuffer_t& buffer,
-    float x0, float y0, float z0,
-    float x1, float y1, float z1,
-    float c0, float c1)
+bool framebuffer_t::copy_gray8_rows(uint8_t* colors, int x, int y, int w, int h, const uint8_t* pixels, int pitch)
 {
-    // 28.4 fixed-point coordinates
-    int X0 = (int)(x0 * 16.0f);
-    int X1 = (int)(x1 * 16.0f);
-    int Y0 = (int)(y0 * 16.0f);
-    int Y1 = (int)(y1 * 16.0f);
-
-    // 8.24 fixed-point coordinate
-    int Z0 = (int)(1.0f / z0 * 0x1000000);
-    int Z1 = (int)(1.0f / z1 * 0x1000000);
-
-    // Swap X/Y if Y is major axis, so X is always major axis
-    const auto flip = abs(Y1 - Y0) > abs(X1 - X0);
-    if (flip)
-    {
-        std::swap(X0, Y0);
-        std::swap(X1, Y1);
-    }
+    const auto x0 = std::max(x, 0);
+    const auto y0 = std::max(y, 0);
+    const auto x1 = std::min(x + w, width);
+    const auto y1 = std::min(y + h, height);
+
+    if (x0 >= x1 || y0 >= y1)
+        return true;
 
-    // Always draw left to right
-    if (X0 > X1)
+    // Tiles covered completely do not need their color cleared first
+    if (clears_deferred)
     {
-        std::swap(X0, X1);
-        std::swap(Y0, Y1);
-        std::swap(Z0, Z1);
-        std::swap(c0, c1);
+        const int tx0 = (x0 + depth_tile_size - 1) / depth_tile_size;
+        const int ty0 = (y0 + depth_tile_size - 1) / depth_tile_size;
+        const int tx1 = x1 == width  ? depth_tiles_x : x1 / depth_tile_size;
+        const int ty1 = y1 == height ? static_cast<int>(tile_clears.size()) / depth_tiles_x : y1 / depth_tile_size;
+
+        for (int ty = ty0; ty < ty1; ++ty)
+            for (int tx = tx0; tx < tx1; ++tx)
+                tile_clears[tx + ty * depth_tiles_x] &= ~clear_color_flag;
     }
 
-    const auto ONE  = 16; // sub-pixel precission
-    const auto DX   = X1 - X0;
-    const auto DY   = abs(Y1 - Y0);
-    const auto step = Y0 < Y1 ? 1 : -1;
-
-    auto error = ONE * DX / 2;
-    auto Y = Y0;
-
-    for (int X = X0; X < X1; X += ONE)
-    {
-        int Z = Z0 + (Z1 - Z0) * (X - X0) / DX;     // 1/z in 8.24 fixed-point coordinate
+    touch_color(x0, y0, x1, y1);
 
-        auto z = 1.0f / (Z * (1.0f / 0x1000000));   // reconstruct z
-        auto c = c0 + (c1 - c0) * (X - X0) / DX;    // interpolate color
+    pixels += (x0 - x) + (y0 - y) * pitch;
 
-        if (flip)
-            buffer.set(Y >> 4, X >> 4, z, c);       // draw pixel (x and y are swapped)
-        else
-            buffer.set(X >> 4, Y >> 4, z, c);       // draw pixel
+    auto out = colors + x0 + y0 * width;
+    for (int row = y0; row < y1; ++row, out += width, pixels += pitch)
+        std::memcpy(out, pixels, x1 - x0);
 
-        error = error - DY * ONE;
-        while (error < 0)
-        {
-            Y     += step;
-            error += DX;
-        }
-    }
+    return true;
 }
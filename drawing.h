@@ -1,11 +1,45 @@
 #pragma once
 #include <vector>
+#include <algorithm>
 #include <cstdint>
+#include <cmath>
+#include <limits>
 #include "font.h"
 
 struct image_t;
 struct framebuffer_t;
 
+struct rect_t
+{
+    int x0, y0;
+    int x1, y1;
+};
+
+// Smallest rect covering both, empty rects (x0 >= x1) are ignored.
+inline rect_t merge_rects(const rect_t& a, const rect_t& b)
+{
+    if (a.x0 >= a.x1)
+        return b;
+    if (b.x0 >= b.x1)
+        return a;
+
+    return { std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1) };
+}
+
+// 8-bit intensity pixel of color, used by framebuffers keeping colors that way.
+inline uint8_t color_to_gray8(float c)
+{
+    return static_cast<uint8_t>(std::max(0, std::min(255, (int)(255 * c))));
+}
+
+// color_to_gray8() of 'count' colors at once, see drawing.inl.
+inline void color_to_gray8_row(const float* c, uint8_t* out, int count);
+
+// Intensity as 12-bit fixed point, [0, 1] maps to 0 .. intensity_max. Tables
+// of per palette conversions are indexed by it.
+constexpr int intensity_bits = 12;
+constexpr int intensity_max  = (1 << intensity_bits) - 1;
+
 void generic_fill_rect_2d(framebuffer_t& buffer, int x0, int y0, int x1, int y1, float color);
 void generic_circle_2d(framebuffer_t& buffer, int cx, int cy, int radius, float color);
 void generic_ellipse_2d(framebuffer_t& buffer, int cx, int cy, int rx, int ry, float color);
@@ -16,17 +50,58 @@ void generic_triangle_2d(framebuffer_t& buffer, int x0, int y0, int x1, int y1,
 void generic_triangle_2d(framebuffer_t& buffer, const image_t& texture, float x0, float y0, float x1, float y1, float x2, float y2, float u0, float v0, float u1, float v1, float u2, float v2, float c0, float c1, float c2, float a0, float a1, float a2);
 void generic_char_2d(framebuffer_t& buffer, const font_t& font, int x, int y, char c, float color);
 
+// Largest width and height in pixels of a triangle rasterized exactly by
+// generic_triangle_3d. Edge functions are 64-bit, limit comes from 28.4 vertex
+// coordinates and edge steps across a block, both stay well within 32 bits.
+// Float screen coordinates still resolve 1/16 of a pixel at this distance.
+const int triangle_3d_max_extent = 1 << 16;
+
 void generic_triangle_3d(framebuffer_t& buffer,
     float x0, float y0, float z0,
     float x1, float y1, float z1,
     float x2, float y2, float z2,
     float c0, float c1, float c2);
 
+void generic_triangle_3d(framebuffer_t& buffer, const rect_t& scissor,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2,
+    float c0, float c1, float c2);
+
 void generic_line_3d(framebuffer_t& buffer,
     float x0, float y0, float z0,
     float x1, float y1, float z1,
     float c0, float c1);
 
+// Same primitives instantiated for a concrete framebuffer type (see concrete_framebuffer_t),
+// overloads above go through virtual interface of framebuffer_t.
+template <typename target_t> void generic_fill_rect_2d(target_t& buffer, int x0, int y0, int x1, int y1, float color);
+template <typename target_t> void generic_circle_2d(target_t& buffer, int cx, int cy, int radius, float color);
+template <typename target_t> void generic_ellipse_2d(target_t& buffer, int cx, int cy, int rx, int ry, float color);
+template <typename target_t> void generic_line_2d(target_t& buffer, int x0, int y0, int x1, int y1, float color);
+template <typename target_t> void generic_hline_2d(target_t& buffer, int x1, int y, int x2, float c);
+template <typename target_t> void generic_vline_2d(target_t& buffer, int x, int y1, int y2, float c);
+template <typename target_t> void generic_triangle_2d(target_t& buffer, int x0, int y0, int x1, int y1, int x2, int y2, float color);
+template <typename target_t> void generic_triangle_2d(target_t& buffer, const image_t& texture, float x0, float y0, float x1, float y1, float x2, float y2, float u0, float v0, float u1, float v1, float u2, float v2, float c0, float c1, float c2, float a0, float a1, float a2);
+template <typename target_t> void generic_char_2d(target_t& buffer, const font_t& font, int x, int y, char c, float color);
+
+template <typename target_t> void generic_triangle_3d(target_t& buffer,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2,
+    float c0, float c1, float c2);
+
+template <typename target_t> void generic_triangle_3d(target_t& buffer, const rect_t& scissor,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2,
+    float c0, float c1, float c2);
+
+template <typename target_t> void generic_line_3d(target_t& buffer,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float c0, float c1);
+
 struct image_t
 {
     const uint8_t*  data;
@@ -37,74 +112,247 @@ struct image_t
     virtual ~image_t() {}
 };
 
+enum class depth_format_t
+{
+    float32,
+    unorm24,    // stored in 32 bits
+    unorm16
+};
+
+// Depth storage formats. Encoding preserves order, so depth test compares
+// stored values directly.
+struct depth_float32_t
+{
+    typedef float value_t;
+
+    static value_t encode(float z)   { return z; }
+    static float   decode(value_t d) { return d; }
+
+    // Depth beyond which everything fails depth test against 'd'
+    static float upper_bound(value_t d) { return d; }
+};
+
+template <typename T, int bits>
+struct depth_unorm_t
+{
+    typedef T value_t;
+
+    static constexpr value_t max_value = static_cast<value_t>((1ull << bits) - 1);
+    static constexpr float   scale     = static_cast<float>(max_value);
+
+    static value_t encode(float z)
+    {
+        // Rounding can push 1.0 past max_value at 24 bits
+        const auto v = (z < 0.0f ? 0.0f : z > 1.0f ? 1.0f : z) * scale + 0.5f;
+        return static_cast<value_t>(v < scale ? v : scale);
+    }
+
+    static float decode(value_t d) { return d * (1.0f / scale); }
+
+    static float upper_bound(value_t d)
+    {
+        if (d == max_value)
+            return std::numeric_limits<float>::infinity();
+
+        // Encoding rounds, step up until next value is reached for sure
+        auto z = (d + 1) * (1.0f / scale);
+        while (encode(z) <= d)
+            z = std::nextafter(z, 2.0f);
+        return z;
+    }
+};
+
+typedef depth_unorm_t<uint32_t, 24> depth_unorm24_t;
+typedef depth_unorm_t<uint16_t, 16> depth_unorm16_t;
+
 struct framebuffer_t
 {
-    std::vector<float>  depth;
-    int                 width;
-    int                 height;
+    static constexpr int depth_tile_size = 8;
+
+    depth_format_t          depth_format;
+    std::vector<float>      depth;          // only one of depth buffers is used, see depth_format
+    std::vector<uint32_t>   depth24;
+    std::vector<uint16_t>   depth16;
+    std::vector<float>      depth_tiles;    // farthest depth of every 8x8 tile, upper bound
+    int                     depth_tiles_x;
+    int                     width;
+    int                     height;
+
+    // Clears are deferred. Every 8x8 tile keeps clear_flags_t of clear it has not
+    // received yet, first write to the tile or resolve_clears() applies it.
+    enum clear_flags_t: uint8_t
+    {
+        clear_color_flag = 1,
+        clear_depth_flag = 2
+    };
+
+    std::vector<uint8_t>    tile_clears;
+    bool                    clears_deferred = false;
+    float                   deferred_color  = 0.0f;
+    float                   deferred_depth  = 1.0f;
+
+    // Colors changed since last present() are tracked per 8x8 tile too.
+    // present() turns them into rectangles before present_impl() is called.
+    enum dirty_flags_t: uint8_t
+    {
+        dirty_written = 1,      // color written since last present
+        dirty_drawn   = 2       // color differs from clear color
+    };
+
+    std::vector<uint8_t>    tile_dirty;
+    std::vector<rect_t>     dirty_rects;    // disjoint, sorted by rows
+    rect_t                  dirty_bounds;   // union of dirty_rects, empty when x0 >= x1
 
-    framebuffer_t(int width, int height):
-        depth(width * height),
+    framebuffer_t(int width, int height, depth_format_t depth_format = depth_format_t::float32):
+        depth_format(depth_format),
+        depth_tiles(((width + depth_tile_size - 1) / depth_tile_size) * ((height + depth_tile_size - 1) / depth_tile_size)),
+        depth_tiles_x((width + depth_tile_size - 1) / depth_tile_size),
         width(width),
-        height(height)
+        height(height),
+        tile_clears(depth_tiles.size()),
+        tile_dirty(depth_tiles.size(), dirty_written),
+        dirty_bounds{ 0, 0, 0, 0 }
     {
+        set_depth_format(depth_format);
+    }
+
+    // Depth content is undefined until next clear(c, d).
+    void set_depth_format(depth_format_t format)
+    {
+        depth_format = format;
+
+        depth.clear();   depth.shrink_to_fit();
+        depth24.clear(); depth24.shrink_to_fit();
+        depth16.clear(); depth16.shrink_to_fit();
+
+        switch (format)
+        {
+            case depth_format_t::float32: depth.resize(width * height);   break;
+            case depth_format_t::unorm24: depth24.resize(width * height); break;
+            case depth_format_t::unorm16: depth16.resize(width * height); break;
+        }
+
+        depth_tiles.assign(depth_tiles.size(), std::numeric_limits<float>::infinity());
+    }
+
+    // Calls f(format, data) with traits (depth_float32_t, ...) and storage of current depth format.
+    template <typename F>
+    auto with_depth(F&& f)
+    {
+        switch (depth_format)
+        {
+            default:
+            case depth_format_t::float32: return f(depth_float32_t(), depth.data());
+            case depth_format_t::unorm24: return f(depth_unorm24_t(), depth24.data());
+            case depth_format_t::unorm16: return f(depth_unorm16_t(), depth16.data());
+        }
     }
 
     virtual ~framebuffer_t() {}
 
     void clear(float c)
     {
-        clear_color(c);
+        defer_clear(clear_color_flag, c, deferred_depth);
     }
 
     void clear(float c, float d)
     {
-        depth.assign(depth.size(), d);
+        with_depth([&](auto format, auto)
+        {
+            depth_tiles.assign(depth_tiles.size(), format.upper_bound(format.encode(d)));
+        });
 
-        clear_color(c);
+        defer_clear(clear_color_flag | clear_depth_flag, c, d);
     }
 
+    // Applies deferred clears to every tile, so buffers can be read directly.
+    void resolve_clears();
+
     void commit()
     {
+        resolve_clears();
         commit_impl();
     }
 
     void present()
     {
+        resolve_clears();
+        collect_dirty_rects();
         present_impl();
     }
 
     void set(int x, int y, float c)
     {
         if (!clip(x, y))
+        {
+            touch_color(x, y, x + 1, y + 1);
             set_color(x, y, c);
+        }
     }
 
     void blend(int x, int y, float c, float a)
     {
         if (!clip(x, y))
+        {
+            touch_color(x, y, x + 1, y + 1);
             blend_color(x, y, c, a);
+        }
     }
 
     void set(int x, int y, float z, float c)
     {
-        if (clip(x, y))
-            return;
+        if (!clip(x, y) && depth_test(x, y, z))
+        {
+            mark_dirty(x, y, x + 1, y + 1);
+            set_color(x, y, saturate(c));
+        }
+    }
 
-        auto& d = depth[width * y + x];
-        if (z > d)
-            return;
+    // Span writes cover 'count' pixels of row 'y' starting at 'x' and are clipped
+    // to the buffer. Bit N of 'mask' selects pixel x + N, so masked spans are at
+    // most span_max pixels long.
+    static constexpr int span_max = 32;
 
-        d = z;
+    void fill_span(int x, int y, int count, float c)
+    {
+        int skip;
+        if (clip_span(x, y, count, skip))
+        {
+            touch_color(x, y, x + count, y + 1);
+            fill_color_span(x, y, count, c);
+        }
+    }
 
-        if (c > 1.0f)
-            c = 1.0f;
-        else if (c < 0.0f)
-            c = 0.0f;
+    void write_span(int x, int y, int count, const float* c, uint32_t mask)
+    {
+        int skip;
+        if (clip_span(x, y, count, skip, mask))
+        {
+            touch_color(x, y, x + count, y + 1);
+            set_color_span(x, y, count, c + skip, mask);
+        }
+    }
 
-        set_color(x, y, c);
+    void blend_span(int x, int y, int count, const float* c, const float* a, uint32_t mask)
+    {
+        int skip;
+        if (clip_span(x, y, count, skip, mask))
+        {
+            touch_color(x, y, x + count, y + 1);
+            blend_color_span(x, y, count, c + skip, a + skip, mask);
+        }
     }
 
+    // Depth tests masked span and stores passing depths. Returns mask of pixels
+    // that passed, colors are left to the caller.
+    uint32_t depth_test_span(int x, int y, int count, const float* z, uint32_t mask);
+
+    // True if depth 'z' fails depth test everywhere in rectangle.
+    bool depth_occluded(int x0, int y0, int x1, int y1, float z) const;
+
+    // Recomputes farthest depth of tile after depth writes that may have raised it.
+    void update_depth_tile(int tile_x, int tile_y);
+
     virtual void fill_rect_2d(int x0, int y0, int x1, int y1, float color)
     {
         generic_fill_rect_2d(*this, x0, y0, x1, y1, color);
@@ -115,17 +363,201 @@ struct framebuffer_t
         generic_char_2d(*this, font, x, y, c, color);
     }
 
+    // Copies 'w' x 'h' block of 8-bit intensities (see color_to_gray8), rows
+    // 'pitch' bytes apart. Block is clipped to the buffer. Returns false if
+    // buffer keeps colors some other way, nothing is written then; empty block
+    // only asks. Blocks in different rows of depth tiles may be copied from
+    // different threads at once.
+    virtual bool copy_gray8_2d(int, int, int, int, const uint8_t*, int)
+    {
+        return false;
+    }
+
 protected:
-    virtual void clear_color(float c) = 0;
+    // Fills whole rows [y0, y1), used by resolve_clears(). Content is not read
+    // back soon, so stores may bypass cache.
+    virtual void clear_color(int y0, int y1, float c) = 0;
     virtual void set_color(int x, int y, float c) = 0;
     virtual void blend_color(int x, int y, float c, float a) = 0;
     virtual void commit_impl() = 0;
     virtual void present_impl() = 0;
 
-private:
+    // Span versions of the above, clipped already. Defaults go pixel by pixel.
+    virtual void fill_color_span(int x, int y, int count, float c)
+    {
+        for (int i = 0; i < count; ++i)
+            set_color(x + i, y, c);
+    }
+
+    virtual void set_color_span(int x, int y, int count, const float* c, uint32_t mask)
+    {
+        for (int i = 0; i < count; ++i)
+            if (mask & (1u << i))
+                set_color(x + i, y, c[i]);
+    }
+
+    virtual void blend_color_span(int x, int y, int count, const float* c, const float* a, uint32_t mask)
+    {
+        for (int i = 0; i < count; ++i)
+            if (mask & (1u << i))
+                blend_color(x + i, y, c[i], a[i]);
+    }
+
     bool clip(int x, int y) const
     {
         return x < 0 || y < 0 || x >= width || y >= height;
     }
+
+    // Applies deferred clears to tiles overlapping rectangle before it is
+    // written, color writes also mark tiles dirty. Rectangle is clipped already.
+    void touch_depth(int x0, int y0, int x1, int y1)
+    {
+        if (clears_deferred)
+            resolve_clears(x0, y0, x1, y1);
+    }
+
+    void touch_color(int x0, int y0, int x1, int y1)
+    {
+        touch_depth(x0, y0, x1, y1);
+        mark_dirty(x0, y0, x1, y1);
+    }
+
+    void mark_dirty(int x0, int y0, int x1, int y1)
+    {
+        for (int ty = y0 / depth_tile_size; ty <= (y1 - 1) / depth_tile_size; ++ty)
+            for (int tx = x0 / depth_tile_size; tx <= (x1 - 1) / depth_tile_size; ++tx)
+                tile_dirty[tx + ty * depth_tiles_x] = dirty_written | dirty_drawn;
+    }
+
+    // copy_gray8_2d() for buffers keeping 8-bit rows of 'width' pixels in 'colors'.
+    bool copy_gray8_rows(uint8_t* colors, int x, int y, int w, int h, const uint8_t* pixels, int pitch);
+
+    void collect_dirty_rects();
+    void defer_clear(unsigned flags, float c, float d);
+    void resolve_clears(int x0, int y0, int x1, int y1);
+    void resolve_clear_tile(int tile_x, int tile_y, unsigned flags);
+
+    bool clip_span(int& x, int y, int& count, int& skip) const
+    {
+        if (y < 0 || y >= height)
+            return false;
+
+        skip   = x < 0 ? -x : 0;
+        x     += skip;
+        count  = std::min(count - skip, width - x);
+
+        return count > 0;
+    }
+
+    bool clip_span(int& x, int y, int& count, int& skip, uint32_t& mask) const
+    {
+        if (!clip_span(x, y, count, skip))
+            return false;
+
+        mask >>= skip;
+        if (count < span_max)
+            mask &= (1u << count) - 1;
+
+        return mask != 0;
+    }
+
+    bool depth_test(int x, int y, float z)
+    {
+        touch_depth(x, y, x + 1, y + 1);
+
+        return with_depth([&](auto format, auto data)
+        {
+            const auto value = format.encode(z);
+
+            auto& d = data[width * y + x];
+            if (value > d)
+                return false;
+
+            d = value;
+
+            return true;
+        });
+    }
+
+    static float saturate(float c)
+    {
+        if (c > 1.0f)
+            return 1.0f;
+        else if (c < 0.0f)
+            return 0.0f;
+        else
+            return c;
+    }
+};
+
+// Base for final framebuffers. Hides pixel functions of framebuffer_t with
+// versions calling derived_t directly, so primitives instantiated for derived_t
+// inline clipping, depth test and color store. Derived type has to befriend it.
+template <typename derived_t>
+struct concrete_framebuffer_t: framebuffer_t
+{
+    using framebuffer_t::framebuffer_t;
+
+    void set(int x, int y, float c)
+    {
+        if (!clip(x, y))
+        {
+            touch_color(x, y, x + 1, y + 1);
+            derived().derived_t::set_color(x, y, c);
+        }
+    }
+
+    void blend(int x, int y, float c, float a)
+    {
+        if (!clip(x, y))
+        {
+            touch_color(x, y, x + 1, y + 1);
+            derived().derived_t::blend_color(x, y, c, a);
+        }
+    }
+
+    void set(int x, int y, float z, float c)
+    {
+        if (!clip(x, y) && depth_test(x, y, z))
+        {
+            mark_dirty(x, y, x + 1, y + 1);
+            derived().derived_t::set_color(x, y, saturate(c));
+        }
+    }
+
+    void fill_span(int x, int y, int count, float c)
+    {
+        int skip;
+        if (clip_span(x, y, count, skip))
+        {
+            touch_color(x, y, x + count, y + 1);
+            derived().derived_t::fill_color_span(x, y, count, c);
+        }
+    }
+
+    void write_span(int x, int y, int count, const float* c, uint32_t mask)
+    {
+        int skip;
+        if (clip_span(x, y, count, skip, mask))
+        {
+            touch_color(x, y, x + count, y + 1);
+            derived().derived_t::set_color_span(x, y, count, c + skip, mask);
+        }
+    }
+
+    void blend_span(int x, int y, int count, const float* c, const float* a, uint32_t mask)
+    {
+        int skip;
+        if (clip_span(x, y, count, skip, mask))
+        {
+            touch_color(x, y, x + count, y + 1);
+            derived().derived_t::blend_color_span(x, y, count, c + skip, a + skip, mask);
+        }
+    }
+
+private:
+    derived_t& derived() { return static_cast<derived_t&>(*this); }
 };
 
+#include "drawing.inl"
+
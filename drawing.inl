@@ -0,0 +1,788 @@
+#pragma once
+#include "drawing.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstdlib>
+
+template <typename T> inline T min3(T a, T b, T c) { return std::min(a, std::min(b, c)); }
+template <typename T> inline T max3(T a, T b, T c) { return std::max(a, std::max(b, c)); }
+
+// Clamped before truncation instead of after, pixels are the same.
+template <typename lanes>
+inline int color_to_gray8_lanes(const float* c, uint8_t* out, int i, int count)
+{
+    const auto zero  = lanes::splat(0.0f);
+    const auto white = lanes::splat(255.0f);
+
+    for (; i + lanes::count <= count; i += lanes::count)
+        lanes::store(out + i, lanes::to_int(lanes::min(lanes::max(lanes::load(c + i) * white, zero), white)));
+
+    return i;
+}
+
+inline void color_to_gray8_row(const float* c, uint8_t* out, int count)
+{
+    auto i = color_to_gray8_lanes<simd_lanes_t>(c, out, 0, count);
+
+    for (; i < count; ++i)
+        out[i] = color_to_gray8(c[i]);
+}
+
+// Depth tests 'count' values against stored depth, integer formats.
+template <typename format_t>
+inline uint32_t depth_test_row(format_t, typename format_t::value_t* depth, int count, const float* z, uint32_t mask)
+{
+    uint32_t passed = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (!(mask & (1u << i)))
+            continue;
+
+        const auto value = format_t::encode(z[i]);
+        if (value > depth[i])
+            continue;
+
+        depth[i] = value;
+        passed  |= 1u << i;
+    }
+
+    return passed;
+}
+
+inline uint32_t depth_test_row(depth_float32_t, float* depth, int count, const float* z, uint32_t mask)
+{
+    typedef simd_lanes_t lanes;
+
+    uint32_t passed = 0;
+
+    int i = 0;
+    for (; i + lanes::count <= count; i += lanes::count)
+    {
+        auto lane_mask = (mask >> i) & ((1u << lanes::count) - 1);
+        if (!lane_mask)
+            continue;
+
+        const auto zv = lanes::load(z + i);
+        auto       d  = lanes::load(depth + i);
+
+        lane_mask &= ~lanes::greater(zv, d);
+        if (!lane_mask)
+            continue;
+
+        lanes::store(depth + i, lanes::select(lane_mask, zv, d));
+
+        passed |= lane_mask << i;
+    }
+
+    for (; i < count; ++i)
+    {
+        if ((mask & (1u << i)) && !(z[i] > depth[i]))
+        {
+            depth[i] = z[i];
+            passed  |= 1u << i;
+        }
+    }
+
+    return passed;
+}
+
+inline uint32_t framebuffer_t::depth_test_span(int x, int y, int count, const float* z, uint32_t mask)
+{
+    int skip;
+    if (!clip_span(x, y, count, skip, mask))
+        return 0;
+
+    touch_depth(x, y, x + count, y + 1);
+
+    const auto passed = with_depth([&](auto format, auto data)
+    {
+        return depth_test_row(format, data + x + y * width, count, z + skip, mask);
+    });
+
+    return passed << skip;
+}
+
+template <typename target_t>
+void generic_fill_rect_2d(target_t& buffer, int x0, int y0, int x1, int y1, float color)
+{
+    if (x0 > x1) std::swap(x0, x1);
+    if (y0 > y1) std::swap(y0, y1);
+
+    for (int y = y0; y < y1; ++y)
+        buffer.fill_span(x0, y, x1 - x0, color);
+}
+
+// http://www.codecodex.com/wiki/Bresenham's_line_algorithm
+template <typename target_t>
+void generic_circle_2d(target_t& buffer, int cx, int cy, int radius, float color)
+{
+    int f     = 1 - radius;
+    int ddF_x = 0;
+    int ddF_y = -2 * radius;
+    int x     = 0;
+    int y     = radius;
+
+    buffer.set(cx, cy + radius, color);
+    buffer.set(cx, cy - radius, color);
+    buffer.set(cx + radius, cy, color);
+    buffer.set(cx - radius, cy, color);
+
+    while (x < y)
+    {
+        if (f >= 0)
+        {
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        x++;
+        ddF_x += 2;
+        f += ddF_x + 1;
+        buffer.set(cx + x, cy + y, color);
+        buffer.set(cx - x, cy + y, color);
+        buffer.set(cx + x, cy - y, color);
+        buffer.set(cx - x, cy - y, color);
+        buffer.set(cx + y, cy + x, color);
+        buffer.set(cx - y, cy + x, color);
+        buffer.set(cx + y, cy - x, color);
+        buffer.set(cx - y, cy - x, color);
+    }
+}
+
+// https://sites.google.com/site/ruslancray/lab/projects/bresenhamscircleellipsedrawingalgorithm/bresenham-s-circle-ellipse-drawing-algorithm
+template <typename target_t>
+void generic_ellipse_2d(target_t& buffer, int cx, int cy, int rx, int ry, float color)
+{
+    const auto a2  = rx * rx;
+    const auto b2  = ry * ry;
+    const auto fa2 = 4 * a2;
+    const auto fb2 = 4 * b2;
+
+    for (int x = 0, y = ry, sigma = 2 * b2 + a2 * (1 - 2 * ry); b2 * x <= a2 * y; x++)
+    {
+        buffer.set(cx + x, cy + y, color);
+        buffer.set(cx - x, cy + y, color);
+        buffer.set(cx + x, cy - y, color);
+        buffer.set(cx - x, cy - y, color);
+        if (sigma >= 0)
+        {
+            sigma += fa2 * (1 - y);
+            y--;
+        }
+        sigma += b2 * ((4 * x) + 6);
+    }
+
+    for (int x = rx, y = 0, sigma = 2 * a2 + b2 * (1 - 2 * rx); a2 * y <= b2 * x; y++)
+    {
+        buffer.set(cx + x, cy + y, color);
+        buffer.set(cx - x, cy + y, color);
+        buffer.set(cx + x, cy - y, color);
+        buffer.set(cx - x, cy - y, color);
+        if (sigma >= 0)
+        {
+            sigma += fb2 * (1 - x);
+            x--;
+        }
+        sigma += a2 * ((4 * y) + 6);
+    }
+}
+
+// http://www.roguebasin.com/index.php?title=Bresenham%27s_Line_Algorithm#C.2B.2B
+template <typename target_t>
+void generic_line_2d(target_t& buffer, int x0, int y0, int x1, int y1, float color)
+{
+    const auto flip = abs(y1 - y0) > abs(x1 - x0);
+    if (flip)
+    {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+
+    if (x0 > x1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+
+    const auto dx   = x1 - x0;
+    const auto dy   = abs(y1 - y0);
+    const auto step = y0 < y1 ? 1 : -1;
+
+    auto error = dx / 2;
+    auto y = y0;
+
+    for (int x = x0; x < x1; ++x)
+    {
+        if (flip)
+            buffer.set(y, x, color);
+        else
+            buffer.set(x, y, color);
+
+        error = error - dy;
+        if (error < 0)
+        {
+            y     += step;
+            error += dx;
+        }
+    }
+}
+
+template <typename target_t>
+void generic_hline_2d(target_t& buffer, int x1, int y, int x2, float c)
+{
+    if (x1 > x2)
+        std::swap(x1, x2);
+
+    buffer.fill_span(x1, y, x2 - x1, c);
+}
+
+template <typename target_t>
+void generic_vline_2d(target_t& buffer, int x, int y1, int y2, float c)
+{
+    if (y1 > y2)
+        std::swap(y1, y2);
+
+    for (int y = y1; y < y2; ++y)
+        buffer.fill_span(x, y, 1, c);
+}
+
+// http://forum.devmaster.net/t/advanced-rasterization/6145
+template <typename target_t>
+void generic_triangle_2d(target_t& buffer, int x0, int y0, int x1, int y1, int x2, int y2, float color)
+{
+    // 28.4 fixed-point coordinates
+    const int Y0 = y0 << 4;
+    const int Y1 = y1 << 4;
+    const int Y2 = y2 << 4;
+
+    const int X0 = x0 << 4;
+    const int X1 = x1 << 4;
+    const int X2 = x2 << 4;
+
+    // Deltas
+    const int DX01 = X0 - X1;
+    const int DX12 = X1 - X2;
+    const int DX20 = X2 - X0;
+
+    const int DY01 = Y0 - Y1;
+    const int DY12 = Y1 - Y2;
+    const int DY20 = Y2 - Y0;
+
+    // Fixed-point deltas
+    const int FDX01 = DX01 << 4;
+    const int FDX12 = DX12 << 4;
+    const int FDX20 = DX20 << 4;
+
+    const int FDY01 = DY01 << 4;
+    const int FDY12 = DY12 << 4;
+    const int FDY20 = DY20 << 4;
+
+    // Bounding rectangle, clipped to buffer
+    const int minx = std::max((min3(X0, X1, X2) + 0x0F) >> 4, 0);
+    const int maxx = std::min((max3(X0, X1, X2) + 0x0F) >> 4, buffer.width);
+    const int miny = std::max((min3(Y0, Y1, Y2) + 0x0F) >> 4, 0);
+    const int maxy = std::min((max3(Y0, Y1, Y2) + 0x0F) >> 4, buffer.height);
+
+    if (minx >= maxx || miny >= maxy)
+        return;
+
+    // Half-edge constants
+    int C0 = DY01 * X0 - DX01 * Y0;
+    int C1 = DY12 * X1 - DX12 * Y1;
+    int C2 = DY20 * X2 - DX20 * Y2;
+
+    // Correct for fill convention
+    if (DY01 < 0 || (DY01 == 0 && DX01 > 0)) C0++;
+    if (DY12 < 0 || (DY12 == 0 && DX12 > 0)) C1++;
+    if (DY20 < 0 || (DY20 == 0 && DX20 > 0)) C2++;
+
+    int CY0 = C0 + DX01 * (miny << 4) - DY01 * (minx << 4);
+    int CY1 = C1 + DX12 * (miny << 4) - DY12 * (minx << 4);
+    int CY2 = C2 + DX20 * (miny << 4) - DY20 * (minx << 4);
+
+    typedef simd_lanes_t lanes;
+
+    const auto SX0 = lanes::splat(-FDY01 * lanes::count);
+    const auto SX1 = lanes::splat(-FDY12 * lanes::count);
+    const auto SX2 = lanes::splat(-FDY20 * lanes::count);
+
+    for (int y = miny; y < maxy; y++)
+    {
+        auto CX0 = lanes::ramp(CY0, -FDY01);
+        auto CX1 = lanes::ramp(CY1, -FDY12);
+        auto CX2 = lanes::ramp(CY2, -FDY20);
+
+        // Triangle covers single run of pixels in a row
+        int run_begin = maxx, run_end = maxx;
+
+        for (int x = minx; x < maxx; x += lanes::count)
+        {
+            auto mask = lanes::positive(CX0) & lanes::positive(CX1) & lanes::positive(CX2);
+            if (maxx - x < lanes::count)
+                mask &= (1u << (maxx - x)) - 1;
+
+            if (mask)
+            {
+                if (run_begin == maxx)
+                    run_begin = x + lowest_bit(mask);
+
+                run_end = x + highest_bit(mask) + 1;
+                if (highest_bit(mask) < lanes::count - 1)
+                    break;
+            }
+            else if (run_begin < maxx)
+                break;
+
+            CX0 = CX0 + SX0;
+            CX1 = CX1 + SX1;
+            CX2 = CX2 + SX2;
+        }
+
+        if (run_begin < run_end)
+            buffer.fill_span(run_begin, y, run_end - run_begin, color);
+
+        CY0 += FDX01;
+        CY1 += FDX12;
+        CY2 += FDX20;
+    }
+}
+
+template <typename target_t>
+void generic_triangle_2d(target_t& buffer, const image_t& texture, float x0, float y0, float x1, float y1, float x2, float y2, float u0, float v0, float u1, float v1, float u2, float v2, float c0, float c1, float c2, float a0, float a1, float a2)
+{
+    // 24.8 fixed-point
+    const int precission = 4;
+    const int mask       = (1 << precission) - 1;
+
+    // Fixed-point coordinates
+    const int Y0 = (int)(y0 * static_cast<float>(1 << precission));
+    const int Y1 = (int)(y1 * static_cast<float>(1 << precission));
+    const int Y2 = (int)(y2 * static_cast<float>(1 << precission));
+
+    const int X0 = (int)(x0 * static_cast<float>(1 << precission));
+    const int X1 = (int)(x1 * static_cast<float>(1 << precission));
+    const int X2 = (int)(x2 * static_cast<float>(1 << precission));
+
+    // Deltas
+    const int DX01 = X0 - X1;
+    const int DX12 = X1 - X2;
+    const int DX20 = X2 - X0;
+
+    const int DY01 = Y0 - Y1;
+    const int DY12 = Y1 - Y2;
+    const int DY20 = Y2 - Y0;
+
+    // Fixed-point deltas
+    const int FDX01 = DX01 << precission;
+    const int FDX12 = DX12 << precission;
+    const int FDX20 = DX20 << precission;
+
+    const int FDY01 = DY01 << precission;
+    const int FDY12 = DY12 << precission;
+    const int FDY20 = DY20 << precission;
+
+    // Bounding rectangle, clipped to buffer
+    const int minx = std::max((min3(X0, X1, X2) + mask) >> precission, 0);
+    const int maxx = std::min((max3(X0, X1, X2) + mask) >> precission, buffer.width);
+    const int miny = std::max((min3(Y0, Y1, Y2) + mask) >> precission, 0);
+    const int maxy = std::min((max3(Y0, Y1, Y2) + mask) >> precission, buffer.height);
+
+    if (minx >= maxx || miny >= maxy)
+        return;
+
+    // Half-edge constants
+    int C0 = DY01 * X0 - DX01 * Y0;
+    int C1 = DY12 * X1 - DX12 * Y1;
+    int C2 = DY20 * X2 - DX20 * Y2;
+
+    // Correct for fill convention
+    if (DY01 < 0 || (DY01 == 0 && DX01 > 0)) C0++;
+    if (DY12 < 0 || (DY12 == 0 && DX12 > 0)) C1++;
+    if (DY20 < 0 || (DY20 == 0 && DX20 > 0)) C2++;
+
+    int CY0 = C0 + DX01 * (miny << precission) - DY01 * (minx << precission);
+    int CY1 = C1 + DX12 * (miny << precission) - DY12 * (minx << precission);
+    int CY2 = C2 + DX20 * (miny << precission) - DY20 * (minx << precission);
+
+    typedef simd_lanes_t lanes;
+
+    const auto viC = lanes::splat(1.0f / (CY0 + CY1 + CY2));
+
+    const auto vc0 = lanes::splat(c0), vc1 = lanes::splat(c1), vc2 = lanes::splat(c2);
+    const auto va0 = lanes::splat(a0), va1 = lanes::splat(a1), va2 = lanes::splat(a2);
+    const auto vu0 = lanes::splat(u0), vu1 = lanes::splat(u1), vu2 = lanes::splat(u2);
+    const auto vv0 = lanes::splat(v0), vv1 = lanes::splat(v1), vv2 = lanes::splat(v2);
+
+    const auto texture_w = lanes::splat(static_cast<float>(texture.width));
+    const auto texture_h = lanes::splat(static_cast<float>(texture.height));
+
+    const auto SX0 = lanes::splat(-FDY01 * lanes::count);
+    const auto SX1 = lanes::splat(-FDY12 * lanes::count);
+    const auto SX2 = lanes::splat(-FDY20 * lanes::count);
+
+    for (int y = miny; y < maxy; y++)
+    {
+        auto CX0 = lanes::ramp(CY0, -FDY01);
+        auto CX1 = lanes::ramp(CY1, -FDY12);
+        auto CX2 = lanes::ramp(CY2, -FDY20);
+
+        for (int x = minx; x < maxx; x += lanes::count)
+        {
+            const auto count = std::min(maxx - x, lanes::count);
+
+            auto coverage = lanes::positive(CX0) & lanes::positive(CX1) & lanes::positive(CX2);
+            coverage &= (1u << count) - 1;
+
+            if (coverage)
+            {
+                const auto W0 = lanes::to_float(CX0);
+                const auto W1 = lanes::to_float(CX1);
+                const auto W2 = lanes::to_float(CX2);
+
+                float   c[lanes::count], a[lanes::count];
+                int32_t u[lanes::count], v[lanes::count];
+                lanes::store(c, (vc2 * W0 + vc0 * W1 + vc1 * W2) * viC);
+                lanes::store(a, (va2 * W0 + va0 * W1 + va1 * W2) * viC);
+                lanes::store(u, lanes::to_int((vu2 * W0 + vu0 * W1 + vu1 * W2) * viC * texture_w));
+                lanes::store(v, lanes::to_int((vv2 * W0 + vv0 * W1 + vv1 * W2) * viC * texture_h));
+
+                for (int i = 0; i < count; ++i)
+                {
+                    if (!(coverage & (1u << i)))
+                        continue;
+
+                    const auto tx = std::max(0, std::min(static_cast<int>(u[i]), texture.width - 1));
+                    const auto ty = std::max(0, std::min(static_cast<int>(v[i]), texture.height - 1));
+
+                    const auto texture_color = texture.data[tx + ty * texture.pitch] * (1.0f / 255.0f);
+
+                    a[i] = texture_color * a[i];
+                }
+
+                buffer.blend_span(x, y, count, c, a, coverage);
+            }
+
+            CX0 = CX0 + SX0;
+            CX1 = CX1 + SX1;
+            CX2 = CX2 + SX2;
+        }
+
+        CY0 += FDX01;
+        CY1 += FDX12;
+        CY2 += FDX20;
+    }
+}
+
+template <typename target_t>
+void generic_char_2d(target_t& buffer, const font_t& font, int x, int y, char c, float color)
+{
+    auto data = font.find(c);
+    if (!data)
+        return;
+
+    // Glyphs are at most 8 pixels wide, every row goes out as one span
+    float      row[8];
+    const auto mask = (1u << font.w) - 1;
+
+    for (int cy = 0; cy < font.h; ++cy)
+    {
+        for (int cx = 0; cx < font.w; ++cx)
+            row[cx] = font.pixel(data, cx, cy) ? color : 0;
+
+        buffer.write_span(x, y + cy, font.w, row, mask);
+    }
+}
+
+template <typename target_t>
+void generic_triangle_3d(target_t& buffer,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2,
+    float c0, float c1, float c2)
+{
+    const rect_t scissor = { 0, 0, buffer.width, buffer.height };
+
+    generic_triangle_3d(buffer, scissor,
+        x0, y0, z0,
+        x1, y1, z1,
+        x2, y2, z2,
+        c0, c1, c2);
+}
+
+// http://forum.devmaster.net/t/advanced-rasterization/6145
+template <typename target_t>
+void generic_triangle_3d(target_t& buffer, const rect_t& scissor,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2,
+    float c0, float c1, float c2)
+{
+    // 28.4 fixed-point coordinates
+    const int Y0 = (int)(y0 * 16.0f);
+    const int Y1 = (int)(y1 * 16.0f);
+    const int Y2 = (int)(y2 * 16.0f);
+
+    const int X0 = (int)(x0 * 16.0f);
+    const int X1 = (int)(x1 * 16.0f);
+    const int X2 = (int)(x2 * 16.0f);
+
+    // Deltas
+    const int DX01 = X0 - X1;
+    const int DX12 = X1 - X2;
+    const int DX20 = X2 - X0;
+
+    const int DY01 = Y0 - Y1;
+    const int DY12 = Y1 - Y2;
+    const int DY20 = Y2 - Y0;
+
+    // Fixed-point deltas
+    const int FDX01 = DX01 << 4;
+    const int FDX12 = DX12 << 4;
+    const int FDX20 = DX20 << 4;
+
+    const int FDY01 = DY01 << 4;
+    const int FDY12 = DY12 << 4;
+    const int FDY20 = DY20 << 4;
+
+    // Bounding rectangle, clipped to scissor
+    const int minx = std::max((min3(X0, X1, X2) + 0x0F) >> 4, scissor.x0);
+    const int maxx = std::min((max3(X0, X1, X2) + 0x0F) >> 4, scissor.x1);
+    const int miny = std::max((min3(Y0, Y1, Y2) + 0x0F) >> 4, scissor.y0);
+    const int maxy = std::min((max3(Y0, Y1, Y2) + 0x0F) >> 4, scissor.y1);
+
+    if (minx >= maxx || miny >= maxy)
+        return;
+
+    // Nearest depth of the triangle, interpolated depth can go few ulps past vertices
+    const auto nearest = min3(z0, z1, z2) * (1.0f - 1.0f / 65536.0f);
+
+    // Hierarchical Z, triangle is hidden everywhere in its bounding rectangle
+    if (buffer.depth_occluded(minx, miny, maxx, maxy, nearest))
+        return;
+
+    // Half-edge constants and functions are 64-bit, vertices may lie far
+    // outside of the buffer (guard band) and triangle covering a 4K buffer
+    // already reaches past 32 bits.
+    int64_t C0 = static_cast<int64_t>(DY01) * X0 - static_cast<int64_t>(DX01) * Y0;
+    int64_t C1 = static_cast<int64_t>(DY12) * X1 - static_cast<int64_t>(DX12) * Y1;
+    int64_t C2 = static_cast<int64_t>(DY20) * X2 - static_cast<int64_t>(DX20) * Y2;
+
+    // Correct for fill convention
+    if (DY01 < 0 || (DY01 == 0 && DX01 > 0)) C0++;
+    if (DY12 < 0 || (DY12 == 0 && DX12 > 0)) C1++;
+    if (DY20 < 0 || (DY20 == 0 && DX20 > 0)) C2++;
+
+    const int64_t CY0 = C0 + static_cast<int64_t>(DX01) * (miny << 4) - static_cast<int64_t>(DY01) * (minx << 4);
+    const int64_t CY1 = C1 + static_cast<int64_t>(DX12) * (miny << 4) - static_cast<int64_t>(DY12) * (minx << 4);
+    const int64_t CY2 = C2 + static_cast<int64_t>(DX20) * (miny << 4) - static_cast<int64_t>(DY20) * (minx << 4);
+
+    const auto C = CY0 + CY1 + CY2;
+    if (C == 0)
+        return;
+
+    typedef simd_lanes_t lanes;
+
+    const auto zero = lanes::splat(0.0f);
+    const auto one  = lanes::splat(1.0f);
+
+    // Blocks match depth tiles of the framebuffer
+    const int block_size = framebuffer_t::depth_tile_size;
+
+    // Screen-space plane equations of depth and intensity, both are affine in
+    // screen space: a(x, y) = a0 + a_dx * (x - vx) + a_dy * (y - vy)
+    const auto iC = 1.0f / static_cast<float>(C);
+    const auto vx = X0 * (1.0f / 16.0f);
+    const auto vy = Y0 * (1.0f / 16.0f);
+
+    const auto z_dx = -16.0f * (z2 * DY01 + z0 * DY12 + z1 * DY20) * iC;
+    const auto z_dy =  16.0f * (z2 * DX01 + z0 * DX12 + z1 * DX20) * iC;
+    const auto c_dx = -16.0f * (c2 * DY01 + c0 * DY12 + c1 * DY20) * iC;
+    const auto c_dy =  16.0f * (c2 * DX01 + c0 * DX12 + c1 * DX20) * iC;
+
+    // Offsets of pixels from start of block row, same for every lane count
+    float z_offsets[block_size + lanes::count];
+    float c_offsets[block_size + lanes::count];
+    for (int i = 0; i < block_size + lanes::count; ++i)
+    {
+        z_offsets[i] = z_dx * static_cast<float>(i);
+        c_offsets[i] = c_dx * static_cast<float>(i);
+    }
+
+    const auto SX0 = lanes::splat(-FDY01 * lanes::count);
+    const auto SX1 = lanes::splat(-FDY12 * lanes::count);
+    const auto SX2 = lanes::splat(-FDY20 * lanes::count);
+
+    // Half-edge functions at pixel (x, y)
+    const auto E0 = [&](int x, int y) { return CY0 + static_cast<int64_t>(FDX01) * (y - miny) - static_cast<int64_t>(FDY01) * (x - minx); };
+    const auto E1 = [&](int x, int y) { return CY1 + static_cast<int64_t>(FDX12) * (y - miny) - static_cast<int64_t>(FDY12) * (x - minx); };
+    const auto E2 = [&](int x, int y) { return CY2 + static_cast<int64_t>(FDX20) * (y - miny) - static_cast<int64_t>(FDY20) * (x - minx); };
+
+    // Number of block corners inside of an edge
+    const auto corners_inside = [](int64_t a, int64_t b, int64_t c, int64_t d) { return (a > 0) + (b > 0) + (c > 0) + (d > 0); };
+
+    // Edge function at block start for 32-bit lanes. Edge with a corner outside
+    // is small over the block and stays exact. Edge with all corners inside is
+    // positive over the whole block, clamped value stays positive as well,
+    // edge changes by much less than 2^30 within a block.
+    const auto lane_edge = [](int64_t e) { return static_cast<int>(std::clamp<int64_t>(e, -(int64_t(1) << 30), int64_t(1) << 30)); };
+
+    for (int by = miny & ~(block_size - 1); by < maxy; by += block_size)
+    {
+        const int y0 = std::max(by, miny);
+        const int y1 = std::min(by + block_size, maxy);
+
+        const auto depth_tiles = buffer.depth_tiles.data() + (by / block_size) * buffer.depth_tiles_x;
+
+        for (int bx = minx & ~(block_size - 1); bx < maxx; bx += block_size)
+        {
+            const int x0 = std::max(bx, minx);
+            const int x1 = std::min(bx + block_size, maxx);
+
+            // Hierarchical Z, everything stored in block is closer
+            if (nearest > depth_tiles[bx / block_size])
+                continue;
+
+            // Edge functions are linear, so corners bound the whole block
+            const auto inside0 = corners_inside(E0(x0, y0), E0(x1 - 1, y0), E0(x0, y1 - 1), E0(x1 - 1, y1 - 1));
+            const auto inside1 = corners_inside(E1(x0, y0), E1(x1 - 1, y0), E1(x0, y1 - 1), E1(x1 - 1, y1 - 1));
+            const auto inside2 = corners_inside(E2(x0, y0), E2(x1 - 1, y0), E2(x0, y1 - 1), E2(x1 - 1, y1 - 1));
+
+            // Trivial reject, whole block is outside of one edge
+            if (inside0 == 0 || inside1 == 0 || inside2 == 0)
+                continue;
+
+            // Trivial accept, whole block is covered
+            const auto covered = inside0 == 4 && inside1 == 4 && inside2 == 4;
+
+            int RY0 = lane_edge(E0(x0, y0));
+            int RY1 = lane_edge(E1(x0, y0));
+            int RY2 = lane_edge(E2(x0, y0));
+
+            auto depth_written = false;
+
+            // Attributes at the start of first block row, stepped by rows below
+            auto z_row = z0 + z_dx * (x0 - vx) + z_dy * (y0 - vy);
+            auto c_row = c0 + c_dx * (x0 - vx) + c_dy * (y0 - vy);
+
+            for (int y = y0; y < y1; y++)
+            {
+                auto CX0 = lanes::ramp(RY0, -FDY01);
+                auto CX1 = lanes::ramp(RY1, -FDY12);
+                auto CX2 = lanes::ramp(RY2, -FDY20);
+
+                // Block row goes through depth test and color store as one span
+                float    z[block_size + lanes::count];
+                float    c[block_size + lanes::count];
+                uint32_t row_mask = 0;
+
+                for (int x = x0; x < x1; x += lanes::count)
+                {
+                    const auto i     = x - x0;
+                    const auto count = std::min(x1 - x, lanes::count);
+
+                    auto mask = covered ? ~0u : lanes::positive(CX0) & lanes::positive(CX1) & lanes::positive(CX2);
+                    mask &= (1u << count) - 1;
+
+                    if (mask)
+                    {
+                        const auto vz = lanes::splat(z_row) + lanes::load(z_offsets + i);
+                        const auto vc = lanes::splat(c_row) + lanes::load(c_offsets + i);
+
+                        lanes::store(z + i, vz);
+                        lanes::store(c + i, lanes::max(lanes::min(vc, one), zero));
+
+                        // Same as framebuffer_t::set(x, y, z, c) for every lane
+                        mask     &= lanes::greater_equal(vz, zero) & lanes::less_equal(vz, one);
+                        row_mask |= mask << i;
+                    }
+
+                    CX0 = CX0 + SX0;
+                    CX1 = CX1 + SX1;
+                    CX2 = CX2 + SX2;
+                }
+
+                if (row_mask)
+                    row_mask = buffer.depth_test_span(x0, y, x1 - x0, z, row_mask);
+
+                if (row_mask)
+                {
+                    depth_written = true;
+
+                    buffer.write_span(x0, y, x1 - x0, c, row_mask);
+                }
+
+                RY0 += FDX01;
+                RY1 += FDX12;
+                RY2 += FDX20;
+
+                z_row += z_dy;
+                c_row += c_dy;
+            }
+
+            if (depth_written)
+                buffer.update_depth_tile(bx / block_size, by / block_size);
+        }
+    }
+}
+
+template <typename target_t>
+void generic_line_3d(target_t& buffer,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float c0, float c1)
+{
+    // 28.4 fixed-point coordinates
+    int X0 = (int)(x0 * 16.0f);
+    int X1 = (int)(x1 * 16.0f);
+    int Y0 = (int)(y0 * 16.0f);
+    int Y1 = (int)(y1 * 16.0f);
+
+    // Swap X/Y if Y is major axis, so X is always major axis
+    const auto flip = abs(Y1 - Y0) > abs(X1 - X0);
+    if (flip)
+    {
+        std::swap(X0, Y0);
+        std::swap(X1, Y1);
+    }
+
+    // Always draw left to right
+    if (X0 > X1)
+    {
+        std::swap(X0, X1);
+        std::swap(Y0, Y1);
+        std::swap(z0, z1);
+        std::swap(c0, c1);
+    }
+
+    const auto ONE  = 16; // sub-pixel precission
+    const auto DX   = X1 - X0;
+    const auto DY   = abs(Y1 - Y0);
+    const auto step = Y0 < Y1 ? 1 : -1;
+
+    auto error = ONE * DX / 2;
+    auto Y = Y0;
+
+    // Depth and color are affine in screen space, step them per pixel
+    const auto step_t = DX > 0 ? static_cast<float>(ONE) / DX : 0.0f;
+    const auto dz     = (z1 - z0) * step_t;
+    const auto dc     = (c1 - c0) * step_t;
+
+    auto z = z0;
+    auto c = c0;
+
+    for (int X = X0; X < X1; X += ONE, z += dz, c += dc)
+    {
+        if (flip)
+            buffer.set(Y >> 4, X >> 4, z, c);       // draw pixel (x and y are swapped)
+        else
+            buffer.set(X >> 4, Y >> 4, z, c);       // draw pixel
+
+        error = error - DY * ONE;
+        while (error < 0)
+        {
+            Y     += step;
+            error += DX;
+        }
+    }
+}
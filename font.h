@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 
 enum font_pack_t
 {
@@ -24,8 +25,38 @@ struct font_t
     font_pack_t         pack;
     const font_range_t* ranges;
     const int           range_count;
+    const byte*         glyphs[256];    // glyph of every character, null if font has none
 
-    const byte* find(char c) const;
+    // Glyph table is filled from ranges, at compile time for fonts defined
+    // constexpr. First range containing character wins.
+    constexpr font_t(int w, int h, const byte* data, font_pack_t pack, const font_range_t* ranges, int range_count):
+        w(w), h(h), data(data), pack(pack), ranges(ranges), range_count(range_count), glyphs()
+    {
+        const auto stride = ((pack == font_pack_row_low) || (pack == font_pack_row_high)) ? w : h;
+
+        for (int i = 0; i < range_count; ++i)
+            for (int c = std::max(ranges[i].start, 0); c < std::min(ranges[i].end, 256); ++c)
+                if (!glyphs[c])
+                    glyphs[c] = data + (ranges[i].offset + (c - ranges[i].start)) * stride;
+    }
+
+    const byte* find(char c) const
+    {
+        return glyphs[static_cast<byte>(c)];
+    }
+
+    // True if pixel of glyph returned by find() is set.
+    bool pixel(const byte* glyph, int x, int y) const
+    {
+        switch (pack)
+        {
+            case font_pack_row_low:     return (glyph[x] & (1 <<      y))  != 0;
+            case font_pack_row_high:    return (glyph[x] & (1 << (7 - y))) != 0;
+            case font_pack_column_low:  return (glyph[y] & (1 <<      x))  != 0;
+            case font_pack_column_high: return (glyph[y] & (1 << (7 - x))) != 0;
+            default:                    return false;
+        }
+    }
 };
 
 const font_t& get_font_5x7();
@@ -103,12 +103,12 @@ static unsigned char s_font_5x7_data[] =
     0x08, 0x1C, 0x2A, 0x08, 0x08  // <-
 };
 
-static const font_range_t s_font_5x7_ranges[] =
+static constexpr font_range_t s_font_5x7_ranges[] =
 {
     { 0x20, 0x20 + lengthof(s_font_5x7_data) / 5, 0 }
 };
 
-static const font_t s_font_5x7
+static constexpr font_t s_font_5x7
 {
     5, 7, s_font_5x7_data, font_pack_row_low,
     s_font_5x7_ranges, lengthof(s_font_5x7_ranges)
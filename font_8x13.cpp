@@ -102,12 +102,12 @@ static unsigned char s_font_8x13_data[] =
     0x00, 0x00, 0x00, 0x60, 0xf1, 0x8f, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // :126
 };
 
-static const font_range_t s_font_8x13_ranges[] =
+static constexpr font_range_t s_font_8x13_ranges[] =
 {
     { 0x20, 0x20 + lengthof(s_font_8x13_data) / 13, 0 }
 };
 
-static const font_t s_font_8x13
+static constexpr font_t s_font_8x13
 {
     8, 13, s_font_8x13_data, font_pack_column_high,
     s_font_8x13_ranges, lengthof(s_font_8x13_ranges)
@@ -103,12 +103,12 @@ static unsigned char s_font_8x8_data[] =
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00    // U+007F
 };
 
-static const font_range_t s_font_8x8_ranges[] =
+static constexpr font_range_t s_font_8x8_ranges[] =
 {
     { 0x20, 0x20 + lengthof(s_font_8x8_data) / 8, 0 }
 };
 
-static const font_t s_font_8x8
+static constexpr font_t s_font_8x8
 {
     8, 8, s_font_8x8_data, font_pack_column_low,
     s_font_8x8_ranges, lengthof(s_font_8x8_ranges)
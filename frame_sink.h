@@ -0,0 +1,13 @@
+#pragma once
+#include "drawing.h"
+#include <cstdint>
+
+// Receives presented frames. Pixels are 8-bit intensity, rows are tightly
+// packed and valid during the call only. 'dirty' covers everything changed
+// since previous frame.
+struct frame_sink_t
+{
+    virtual ~frame_sink_t() {}
+
+    virtual void frame(const uint8_t* pixels, int width, int height, const rect_t& dirty) = 0;
+};
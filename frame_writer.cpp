@@ -0,0 +1,192 @@
+#include "frame_writer.h"
+#include <algorithm>
+#include <cstring>
+
+frame_writer_t::frame_writer_t(const char* path, frame_format_t format, int width, int height, int fps, int slot_count, present_policy_t policy):
+    format(format),
+    width(width),
+    height(height),
+    policy(policy),
+    path(path),
+    fps(fps),
+    slots(std::max(slot_count, 1), std::vector<uint8_t>(static_cast<size_t>(width) * height))
+{
+    switch (format)
+    {
+        case frame_format_t::pgm:
+            break;
+
+        case frame_format_t::ppm:
+            scratch.resize(static_cast<size_t>(width) * 3);
+            break;
+
+        case frame_format_t::y4m:
+            // Gray has no color, both chroma planes are constant
+            scratch.assign(static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2), 128);
+
+            stream = fopen(path, "wb");
+            if (!stream || fprintf(stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", width, height, fps) < 0)
+            {
+                fprintf(stderr, "frame_writer: cannot write '%s'\n", path);
+                error = true;
+            }
+            break;
+    }
+
+    writer = std::thread([this] { writer_main(); });
+}
+
+frame_writer_t::~frame_writer_t()
+{
+    close();
+}
+
+void frame_writer_t::frame(const uint8_t* pixels, int width, int height, const rect_t&)
+{
+    if (closed || error || width != this->width || height != this->height)
+    {
+        ++dropped;
+        return;
+    }
+
+    const auto count = static_cast<unsigned>(slots.size());
+    const auto index = head.load();
+
+    for (;;)
+    {
+        const auto taken = tail.load();
+        if (index - taken < count)
+            break;
+
+        if (policy == present_policy_t::drop)
+        {
+            ++dropped;
+            return;
+        }
+
+        tail.wait(taken);
+    }
+
+    std::memcpy(slots[index % count].data(), pixels, slots[index % count].size());
+
+    head = index + 1;
+
+    ++published;
+    published.notify_one();
+}
+
+void frame_writer_t::close()
+{
+    if (!writer.joinable())
+        return;
+
+    closed = true;
+
+    ++published;
+    published.notify_one();
+
+    writer.join();
+
+    if (stream && fclose(stream) != 0 && !error)
+    {
+        fprintf(stderr, "frame_writer: cannot write '%s'\n", path.c_str());
+        error = true;
+    }
+    stream = nullptr;
+}
+
+void frame_writer_t::writer_main()
+{
+    const auto count = static_cast<unsigned>(slots.size());
+
+    for (;;)
+    {
+        // Counter is read before looking at queue, so frame published in between is not missed
+        const auto seen  = published.load();
+        const auto index = tail.load();
+
+        if (index != head)
+        {
+            // After an error queue is still drained, render thread may wait for a slot
+            if (!error)
+            {
+                if (write(slots[index % count].data()))
+                    ++written;
+                else
+                    error = true;
+            }
+
+            tail = index + 1;
+            tail.notify_one();
+            continue;
+        }
+
+        if (closed)
+            break;
+
+        published.wait(seen);
+    }
+}
+
+bool frame_writer_t::write(const uint8_t* pixels)
+{
+    if (format == frame_format_t::y4m)
+        return write_y4m(pixels);
+    else
+        return write_still(pixels);
+}
+
+bool frame_writer_t::write_still(const uint8_t* pixels)
+{
+    const auto ppm = format == frame_format_t::ppm;
+
+    char file_path[1024];
+    snprintf(file_path, sizeof(file_path), "%s%05d.%s", path.c_str(), written.load(), ppm ? "ppm" : "pgm");
+
+    auto file = fopen(file_path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "frame_writer: cannot open '%s' for writing\n", file_path);
+        return false;
+    }
+
+    auto ok = fprintf(file, "%s\n%d %d\n255\n", ppm ? "P6" : "P5", width, height) > 0;
+
+    if (ppm)
+    {
+        for (int y = 0; ok && y < height; ++y)
+        {
+            auto row = pixels + static_cast<size_t>(y) * width;
+            for (int x = 0; x < width; ++x)
+                scratch[x * 3 + 0] = scratch[x * 3 + 1] = scratch[x * 3 + 2] = row[x];
+
+            ok = fwrite(scratch.data(), 1, scratch.size(), file) == scratch.size();
+        }
+    }
+    else
+        ok = ok && fwrite(pixels, 1, static_cast<size_t>(width) * height, file) == static_cast<size_t>(width) * height;
+
+    if (fclose(file) != 0 || !ok)
+    {
+        fprintf(stderr, "frame_writer: cannot write '%s'\n", file_path);
+        return false;
+    }
+
+    return true;
+}
+
+bool frame_writer_t::write_y4m(const uint8_t* pixels)
+{
+    const auto size = static_cast<size_t>(width) * height;
+
+    const auto ok =
+        fputs("FRAME\n", stream) >= 0 &&
+        fwrite(pixels, 1, size, stream) == size &&
+        fwrite(scratch.data(), 1, scratch.size(), stream) == scratch.size() &&
+        fwrite(scratch.data(), 1, scratch.size(), stream) == scratch.size();
+
+    if (!ok)
+        fprintf(stderr, "frame_writer: cannot write '%s'\n", path.c_str());
+
+    return ok;
+}
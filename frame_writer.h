@@ -0,0 +1,66 @@
+#pragma once
+#include "frame_sink.h"
+#include "present_queue.h"
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+
+enum class frame_format_t
+{
+    pgm,        // still per frame, <path><frame>.pgm, gray
+    ppm,        // still per frame, <path><frame>.ppm, RGB
+    y4m         // single YUV4MPEG2 stream to <path>, 4:2:0 full range
+};
+
+// Writes frames to disk on a thread of its own. frame() copies pixels to one
+// of preallocated slots and returns, nothing is allocated per frame. Slots
+// form a FIFO, when all are waiting for disk policy decides whether render
+// thread waits (block) or frame is skipped (drop).
+//
+// Frames have to match size writer was created with. First I/O error stops
+// writing, remaining frames are discarded.
+struct frame_writer_t final: frame_sink_t
+{
+    frame_writer_t(const char* path, frame_format_t format, int width, int height, int fps = 30, int slot_count = 4, present_policy_t policy = present_policy_t::block);
+    ~frame_writer_t();
+
+    frame_writer_t(const frame_writer_t&) = delete;
+    frame_writer_t& operator=(const frame_writer_t&) = delete;
+
+    virtual void frame(const uint8_t* pixels, int width, int height, const rect_t& dirty) override final;
+
+    // Waits for queued frames to be written and closes output. Called by
+    // destructor too.
+    void close();
+
+    bool failed() const         { return error; }
+    int  written_frames() const { return written; }
+    int  dropped_frames() const { return dropped; }
+
+    const frame_format_t   format;
+    const int              width;
+    const int              height;
+    const present_policy_t policy;
+
+private:
+    void writer_main();
+    bool write(const uint8_t* pixels);
+    bool write_still(const uint8_t* pixels);
+    bool write_y4m(const uint8_t* pixels);
+
+    std::string                         path;
+    int                                 fps;
+    FILE*                               stream = nullptr;   // y4m only
+    std::vector<std::vector<uint8_t>>   slots;
+    std::vector<uint8_t>                scratch;            // writer thread only, RGB rows or chroma planes
+    std::atomic<unsigned>               head      { 0 };    // frames queued, render thread writes
+    std::atomic<unsigned>               tail      { 0 };    // frames taken from queue, writer thread writes
+    std::atomic<unsigned>               published { 0 };    // bumped to wake writer thread
+    std::atomic<bool>                   closed    { false };
+    std::atomic<bool>                   error     { false };
+    std::atomic<int>                    written   { 0 };
+    std::atomic<int>                    dropped   { 0 };
+    std::thread                         writer;
+};
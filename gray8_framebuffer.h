@@ -0,0 +1,106 @@
+#pragma once
+#include "drawing.h"
+#include "simd.h"
+#include <algorithm>
+
+// Base for final framebuffers keeping 8-bit intensity (see color_to_gray8) in
+// rows of 'width' pixels. Derived type points 'colors' at storage of the frame
+// being rendered and takes care of presenting it.
+template <typename derived_t>
+struct gray8_framebuffer_t: concrete_framebuffer_t<derived_t>
+{
+    typedef uint8_t pixel_t;
+
+    pixel_t* colors = nullptr;  // buffer current frame is rendered to
+
+    using concrete_framebuffer_t<derived_t>::concrete_framebuffer_t;
+
+    virtual void char_2d(const font_t& font, int x, int y, char c, float color) override final
+    {
+        auto data = font.find(c);
+        if (!data)
+            return;
+
+        // Glyph is clipped to the buffer
+        const auto gx0 = std::max(0, -x);
+        const auto gy0 = std::max(0, -y);
+        const auto gx1 = std::min(font.w, this->width  - x);
+        const auto gy1 = std::min(font.h, this->height - y);
+        if (gx0 >= gx1 || gy0 >= gy1)
+            return;
+
+        auto color_pixel = color_to_pixel(color);
+        auto bg_pixel    = color_to_pixel(0);
+
+        this->touch_color(x + gx0, y + gy0, x + gx1, y + gy1);
+
+        auto out_row = colors + x + y * this->width;
+        for (int gy = gy0; gy < gy1; ++gy)
+            for (int gx = gx0; gx < gx1; ++gx)
+                out_row[gx + gy * this->width] = font.pixel(data, gx, gy) ? color_pixel : bg_pixel;
+    }
+
+    virtual bool copy_gray8_2d(int x, int y, int w, int h, const uint8_t* pixels, int pitch) override final
+    {
+        return this->copy_gray8_rows(colors, x, y, w, h, pixels, pitch);
+    }
+
+protected:
+    virtual void clear_color(int y0, int y1, float c) override final
+    {
+        stream_fill(colors + y0 * this->width, static_cast<size_t>(y1 - y0) * this->width, color_to_pixel(c));
+    }
+
+    virtual void set_color(int x, int y, float c) override final
+    {
+        colors[x + y * this->width] = color_to_pixel(c);
+    }
+
+    virtual void blend_color(int x, int y, float c, float a) override final
+    {
+        colors[x + y * this->width] = blend_pixel(colors[x + y * this->width], c, a);
+    }
+
+    virtual void fill_color_span(int x, int y, int count, float c) override final
+    {
+        std::fill_n(colors + x + y * this->width, count, color_to_pixel(c));
+    }
+
+    virtual void set_color_span(int x, int y, int count, const float* c, uint32_t mask) override final
+    {
+        auto out = colors + x + y * this->width;
+        if (mask == (count < framebuffer_t::span_max ? (1u << count) - 1 : ~0u))
+        {
+            color_to_gray8_row(c, out, count);
+            return;
+        }
+
+        pixel_t pixels[framebuffer_t::span_max];
+        color_to_gray8_row(c, pixels, count);
+
+        for (int i = 0; i < count; ++i)
+            if (mask & (1u << i))
+                out[i] = pixels[i];
+    }
+
+    virtual void blend_color_span(int x, int y, int count, const float* c, const float* a, uint32_t mask) override final
+    {
+        auto out = colors + x + y * this->width;
+        for (int i = 0; i < count; ++i)
+            if (mask & (1u << i))
+                out[i] = blend_pixel(out[i], c[i], a[i]);
+    }
+
+private:
+    pixel_t color_to_pixel(float c) const
+    {
+        return color_to_gray8(c);
+    }
+
+    pixel_t blend_pixel(pixel_t back, float c, float a) const
+    {
+        auto ia = (int)(a * 255);
+
+        return static_cast<pixel_t>((int)back + ((int)color_to_pixel(c) - (int)back) * ia / 255);
+    }
+};
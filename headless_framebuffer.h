@@ -0,0 +1,36 @@
+#pragma once
+#include "gray8_framebuffer.h"
+#include "frame_sink.h"
+#include <vector>
+
+// Framebuffer without a window, renders to memory. Every present() hands the
+// frame to the sink, pixels stay valid until next frame starts rendering.
+struct headless_framebuffer_t final: gray8_framebuffer_t<headless_framebuffer_t>
+{
+    friend concrete_framebuffer_t;
+
+    std::vector<pixel_t> buffer;
+    frame_sink_t*        sink;
+    int                  frame_count = 0;
+
+    headless_framebuffer_t(int width, int height, frame_sink_t* sink = nullptr):
+        gray8_framebuffer_t(width, height),
+        buffer(width * height, 0),
+        sink(sink)
+    {
+        colors = buffer.data();
+    }
+
+protected:
+    virtual void commit_impl() override final
+    {
+    }
+
+    virtual void present_impl() override final
+    {
+        if (sink)
+            sink->frame(colors, width, height, dirty_bounds);
+
+        ++frame_count;
+    }
+};
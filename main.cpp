@@ -3,260 +3,26 @@
 #include "drawing.h"
 #include "math.h"
 #include "mesh.h"
+#include "tile_rasterizer.h"
+#include "toaster_framebuffer.h"
+#include "ascii_framebuffer.h"
+#include "scene.h"
+#include "frame_writer.h"
 #include "imgui/imgui.h"
 
 #include <vector>
 #include <algorithm>
 #include <iterator>
 #include <cstdlib>
+#include <atomic>
+#include <optional>
 
-struct toaster_framebuffer_t final: framebuffer_t
-{
-    typedef PixelToaster::TrueColorPixel pixel_t;
-
-    PixelToaster::Display& display;
-    std::vector<pixel_t>   colors;
-
-    toaster_framebuffer_t(PixelToaster::Display& display):
-        framebuffer_t(display.width(), display.height()),
-        display(display),
-        colors(width * height, pixel_t(0, 0, 0, 0))
-    {
-    }
-
-    void fill_rect_2d(int x0, int y0, int x1, int y1, float color) override final
-    {
-        auto pixel = color_to_pixel(color);
-
-        if (x0 > x1) std::swap(x0, x1);
-        if (y0 > y1) std::swap(y0, y1);
-
-        auto out_row = colors.data() + x0 + y0 * width;
-        for (int y = y0; y < y1; ++y, out_row += width)
-        {
-            auto out = out_row;
-            for (int x = x0; x < x1; ++x, ++out)
-                *out = pixel;
-        }
-    }
-
-    virtual void char_2d(const font_t& font, int x, int y, char c, float color) override final
-    {
-        auto data = font.find(c);
-        if (!data)
-            return;
-
-        typedef bool (*unpack_font_proc)(const uint8_t* data, int x, int y);
-
-        unpack_font_proc unpack_font = nullptr;
-        switch (font.pack)
-        {
-            case font_pack_row_low:     unpack_font = [](const uint8_t* data, int x, int y) { return (data[x] & (1 <<      y))  != 0; }; break;
-            case font_pack_row_high:    unpack_font = [](const uint8_t* data, int x, int y) { return (data[x] & (1 << (7 - y))) != 0; }; break;
-            case font_pack_column_low:  unpack_font = [](const uint8_t* data, int x, int y) { return (data[y] & (1 <<      x))  != 0; }; break;
-            case font_pack_column_high: unpack_font = [](const uint8_t* data, int x, int y) { return (data[y] & (1 << (7 - x))) != 0; }; break;
-            default: return;
-        }
-
-        auto color_pixel = color_to_pixel(color);
-        auto bg_pixel    = color_to_pixel(0);
-
-        auto out_row = colors.data() + x + y * width;
-        for (int y = 0; y < font.h; ++y, out_row += width)
-        {
-            auto out = out_row;
-            for (int x = 0; x < font.w; ++x, ++out)
-                *out = unpack_font(data, x, y) ? color_pixel : bg_pixel;
-        }
-    }
-
-protected:
-    virtual void clear_color(float c) override final
-    {
-        colors.assign(width * height, color_to_pixel(c));
-    }
-
-    virtual void set_color(int x, int y, float c) override final
-    {
-        auto back  = colors[x + width * y];
-        auto pixel = color_to_pixel(c);
-
-        colors[x + width * y] = pixel;
-    }
-
-    virtual void blend_color(int x, int y, float c, float a) override final
-    {
-        auto back  = colors[x + width * y];
-        auto pixel = color_to_pixel(c);
-
-        auto ia = (int)(a * 255);
-
-        pixel.r = (int)back.r + ((int)pixel.r - (int)back.r) * ia / 255;
-        pixel.g = (int)back.g + ((int)pixel.g - (int)back.g) * ia / 255;
-        pixel.b = (int)back.b + ((int)pixel.b - (int)back.b) * ia / 255;
-
-        colors[x + y * width] = pixel;
-    }
-
-    virtual void commit_impl() override final
-    {
-    }
-
-    virtual void present_impl() override final
-    {
-        display.update(colors);
-    }
-
-private:
-    pixel_t color_to_pixel(float c) const
-    {
-        auto brightness = std::max(0, std::min(255, (int)(255 * c)));
-        return pixel_t(brightness, brightness, brightness, 255);
-    }
-};
-
-struct ascii_font_t
-{
-    const font_t& font;
-    const char*   palette;
-    const int     padding;
-};
-
-struct ascii_framebuffer_t final: framebuffer_t
-{
-    framebuffer_t&     buffer;
-    const font_t&      font;
-    std::vector<float> color;
-    int                font_width;
-    int                font_height;
-    std::vector<char>  palette;
-
-    ascii_framebuffer_t(framebuffer_t& buffer, const ascii_font_t& font):
-        framebuffer_t(buffer.width / (font.font.w + font.padding), buffer.height / (font.font.h + font.padding)),
-        buffer(buffer),
-        font(font.font),
-        color(width * height),
-        font_width(font.font.w + font.padding),
-        font_height(font.font.h + font.padding),
-        palette(font.palette, font.palette + strlen(font.palette))
-    {
-    }
-
-    void dither(bool useZbuffer)
-    {
-        const auto palette_size = (float)palette.size();
-
-        const auto width = this->width;
-        const auto height = this->height;
-
-        const auto k1Per15 = 1.0f / (palette_size - 1);
-        const auto k1Per16 = 1.0f / 16.0f;
-        const auto k3Per16 = 3.0f / 16.0f;
-        const auto k5Per16 = 5.0f / 16.0f;
-        const auto k7Per16 = 7.0f / 16.0f;
-
-        int x = 0, y = 0;
-        auto depth = this->depth.data();
-        for (auto pixel = color.data(), pixelEnd = color.data() + color.size(); pixel < pixelEnd; ++pixel, ++x, ++depth)
-        {
-            if (x == width)
-            {
-                x = 0;
-                ++y;
-            }
-
-            auto c = *pixel;
-            auto c2 = std::min(1.0f, std::max(0.0f, floorf(c * palette_size) * k1Per15));
-            auto ce = c - c2;
-
-            *pixel = c2;
-
-            auto n1 = pixel + 1;
-            auto n2 = pixel + width - 1;
-            auto n3 = pixel + width;
-            auto n4 = pixel + width + 1;
-
-            auto d1 = depth + 1;
-            auto d2 = depth + width - 1;
-            auto d3 = depth + width;
-            auto d4 = depth + width + 1;
-
-            if (x < width - 1)
-                *n1 += (ce * k7Per16) * (useZbuffer ? std::clamp(1.0f - fabsf(*depth - *d1), 0.0f, 1.0f) : 1.0f);
-
-            if (y < height - 1)
-            {
-                *n3 += ce * k5Per16 * (useZbuffer ? std::clamp(1.0f - fabsf(*depth - *d3), 0.0f, 1.0f) : 1.0f);
-
-                if (x > 0)
-                    *n2 += ce * k3Per16 * (useZbuffer ? std::clamp(1.0f - fabsf(*depth - *d2), 0.0f, 1.0f) : 1.0f);
-
-                if (x < height - 1)
-                    *n4 += ce * k1Per16 * (useZbuffer ? std::clamp(1.0f - fabsf(*depth - *d4), 0.0f, 1.0f) : 1.0f);
-            }
-        }
-    }
-
-protected:
-    virtual void clear_color(float c) override final
-    {
-        color.assign(width * height, c);
-        buffer.clear(c);
-    }
-
-    virtual void set_color(int x, int y, float c) override final
-    {
-        color[x + y * width] = c;
-    }
-
-    virtual void blend_color(int x, int y, float c, float a) override final
-    {
-        color[x + y * width] += (c - color[x + y * width]) * a;
-    }
-
-    virtual void commit_impl() override final
-    {
-        int x = 0, y = 0;
-        for (auto pixel = color.data(), pixelEnd = color.data() + color.size(); pixel < pixelEnd; ++pixel, ++x)
-        {
-            if (x == width)
-            {
-                x = 0;
-                ++y;
-            }
-
-            auto color = *pixel;
-
-            if (color == 0.0f)
-                continue;
-
-            auto c = color_to_char(color);
-
-            buffer.char_2d(font, x * font_width, y * font_height, c, 1.0f);
-
-            // buffer.fill_rect_2d(x * font_width, y * font_height, x * font_width + font_width - 1, y * font_height + font_height - 1, color);
-        }
-    }
-
-    virtual void present_impl() override final
-    {
-        buffer.present();
-    }
-
-private:
-    char color_to_char(float c) const
-    {
-        c = std::min(1.0f, std::max(0.0f, c));
-
-        auto index = std::min<int>(static_cast<int>(palette.size() * c), static_cast<int>(palette.size() - 1));
-
-        return palette[index];
-    }
-};
-
-static framebuffer_t* imgui_render_target = nullptr;
+static toaster_framebuffer_t* imgui_render_target = nullptr;
+static rect_t                 imgui_drawn;    // bounds of last drawn lists, ASCII cells under it are drawn again
 static void render_draw_lists(ImDrawData* draw_data)
 {
+    imgui_drawn = {};
+
     for (int n = 0; n < draw_data->CmdListsCount; n++)
     {
         const ImDrawList* const cmd_list = draw_data->CmdLists[n];
@@ -286,6 +52,12 @@ static void render_draw_lists(ImDrawData* draw_data)
                     const auto v1 = vertices[i1];
                     const auto v2 = vertices[i2];
 
+                    imgui_drawn = merge_rects(imgui_drawn, {
+                        static_cast<int>(std::min({ v0.pos.x, v1.pos.x, v2.pos.x })),
+                        static_cast<int>(std::min({ v0.pos.y, v1.pos.y, v2.pos.y })),
+                        static_cast<int>(std::max({ v0.pos.x, v1.pos.x, v2.pos.x })) + 2,
+                        static_cast<int>(std::max({ v0.pos.y, v1.pos.y, v2.pos.y })) + 2 });
+
                     const auto vc0 = ImColor(v0.col);
                     const auto vc1 = ImColor(v1.col);
                     const auto vc2 = ImColor(v2.col);
@@ -330,152 +102,52 @@ static void render_draw_lists(ImDrawData* draw_data)
     }
 }
 
-struct transformed_vertex_t
+// Events arrive on present thread, render thread applies them to ImGui at
+// frame start. Mouse position is kept relative to display size.
+struct imgui_listener final: public PixelToaster::Listener
 {
-    vec4  p{};
-    vec3  n{};
-    float c{};
+    std::atomic<float>    mouse_x       { 0.0f };
+    std::atomic<float>    mouse_y       { 0.0f };
+    std::atomic<unsigned> mouse_buttons { 0 };
 
-    friend transformed_vertex_t lerp(const transformed_vertex_t& a, const transformed_vertex_t& b, float t)
+    void apply(ImGuiIO& io) const
     {
-        return
-        {
-            a.p + t * (b.p - a.p),
-            a.n + t * (b.n - a.n),
-            a.c + t * (b.c - a.c),
-        };
-    }
-};
-
-struct transformed_triangle_t
-{
-    transformed_vertex_t a{}, b{}, c{};
-};
-
-struct triangle_clip_result_t
-{
-    transformed_triangle_t triangles[64];
-    int                    triangle_count = 0;
-};
+        const auto buttons = mouse_buttons.load();
 
-static void clip_triangle(const transformed_triangle_t& triangle, triangle_clip_result_t& result)
-{
-    triangle_clip_result_t buffers[2];
-    triangle_clip_result_t* input  = &buffers[0];
-    triangle_clip_result_t* output = &buffers[1];
-
-    input->triangles[0]   = triangle;
-    input->triangle_count = 1;
+        io.MousePos.x  = mouse_x * imgui_render_target->width;
+        io.MousePos.y  = mouse_y * imgui_render_target->height;
+        io.MouseDown[0] = (buttons & 1) != 0;
+        io.MouseDown[1] = (buttons & 2) != 0;
+        io.MouseDown[2] = (buttons & 4) != 0;
+    }
 
-    struct clip_rule_t
+    virtual void onMouseButtonDown(PixelToaster::DisplayInterface& display, PixelToaster::Mouse mouse) override final
     {
-        using test_t  = bool  (*)(const transformed_vertex_t& v) noexcept;
-        using limit_t = float (*)(const transformed_vertex_t& v) noexcept;
-
-        test_t  test;
-        limit_t value;
-        limit_t limit;
-    };
+        move(display, mouse);
+        mouse_buttons |= pressed(mouse);
+    }
 
-    static constexpr clip_rule_t clip_rules[]
-    {
-        { [](const auto& v) noexcept { return  v.p.x <= v.p.w; }, [](const auto& v) noexcept { return v.p.x; }, [](const auto& v) noexcept { return                       v.p.w; } },
-        { [](const auto& v) noexcept { return  v.p.y <= v.p.w; }, [](const auto& v) noexcept { return v.p.y; }, [](const auto& v) noexcept { return                       v.p.w; } },
-        { [](const auto& v) noexcept { return  v.p.z <= v.p.w; }, [](const auto& v) noexcept { return v.p.z; }, [](const auto& v) noexcept { return                       v.p.w; } },
-        { [](const auto& v) noexcept { return -v.p.w  < v.p.x; }, [](const auto& v) noexcept { return v.p.x; }, [](const auto& v) noexcept { return -v.p.w + FLT_EPSILON * 2.0f; } },
-        { [](const auto& v) noexcept { return -v.p.w  < v.p.y; }, [](const auto& v) noexcept { return v.p.y; }, [](const auto& v) noexcept { return -v.p.w + FLT_EPSILON * 2.0f; } },
-        { [](const auto& v) noexcept { return   0.0f  < v.p.z; }, [](const auto& v) noexcept { return v.p.z; }, [](const auto& v) noexcept { return          FLT_EPSILON * 2.0f; } },
-    };
-
-    for (const auto& rule : clip_rules)
+    virtual void onMouseButtonUp(PixelToaster::DisplayInterface& display, PixelToaster::Mouse mouse) override final
     {
-        const bool is_last_rule = &rule == &clip_rules[sizeof(clip_rules) / sizeof(*clip_rules) - 1];
-
-        if (is_last_rule)
-            output = &result;
-
-        output->triangle_count = 0;
-
-        for (int i = 0; i < input->triangle_count; ++i)
-        {
-            const auto& triangle = input->triangles[i];
-
-            const auto test0 = rule.test(triangle.a);
-            const auto test1 = rule.test(triangle.b);
-            const auto test2 = rule.test(triangle.c);
-
-            const auto count = static_cast<int>(test0) + static_cast<int>(test1) + static_cast<int>(test2);
-
-            if (count == 0)
-                continue;
-
-            if (count == 3)
-            {
-                output->triangles[output->triangle_count++] = triangle;
-            }
-            else
-            {
-                auto A = &triangle.a, B = &triangle.b, C = &triangle.c;
-                     if (count == 2 ? !test1 : test1) { A = &triangle.b; B = &triangle.c; C = &triangle.a; }
-                else if (count == 2 ? !test2 : test2) { A = &triangle.c; B = &triangle.a; C = &triangle.b; }
-
-                const auto a_value = rule.value(*A);
-                const auto b_value = rule.value(*B);
-                const auto c_value = rule.value(*C);
-
-                const auto a_limit = rule.limit(*A);
-                const auto b_limit = rule.limit(*B);
-                const auto c_limit = rule.limit(*C);
-
-                auto t_b = (b_limit - b_value) / (b_limit - a_limit - b_value + a_value);
-                auto t_c = (c_limit - c_value) / (c_limit - a_limit - c_value + a_value);
-
-                auto vb = lerp(*B, *A, t_b);
-                auto vc = lerp(*C, *A, t_c);
-
-                if (count == 2)
-                {
-                    output->triangles[output->triangle_count++] = { *B, *C, vb };
-                    output->triangles[output->triangle_count++] = { *C, vc, vb };
-                }
-                else
-                {
-                    output->triangles[output->triangle_count++] = { *A, vb, vc };
-                }
-            }
-        }
-
-        std::swap(input, output);
+        move(display, mouse);
+        mouse_buttons &= pressed(mouse);
     }
-}
 
-struct imgui_listener final: public PixelToaster::Listener
-{
-    virtual void onMouseButtonDown(PixelToaster::DisplayInterface& display, PixelToaster::Mouse mouse) override final
+    virtual void onMouseMove(PixelToaster::DisplayInterface& display, PixelToaster::Mouse mouse) override final
     {
-        auto& io = ImGui::GetIO();
-        io.MousePos.x = mouse.x * imgui_render_target->width  / display.width();
-        io.MousePos.y = mouse.y * imgui_render_target->height / display.height();
-        if (mouse.buttons.left)   io.MouseDown[0] = true;
-        if (mouse.buttons.right)  io.MouseDown[1] = true;
-        if (mouse.buttons.middle) io.MouseDown[2] = true;
+        move(display, mouse);
     }
 
-    virtual void onMouseButtonUp(PixelToaster::DisplayInterface& display, PixelToaster::Mouse mouse) override final
+private:
+    void move(PixelToaster::DisplayInterface& display, const PixelToaster::Mouse& mouse)
     {
-        auto& io = ImGui::GetIO();
-        io.MousePos.x = mouse.x * imgui_render_target->width / display.width();
-        io.MousePos.y = mouse.y * imgui_render_target->height / display.height();
-        if (io.MouseDown[0] && !mouse.buttons.left)   io.MouseDown[0] = false;
-        if (io.MouseDown[1] && !mouse.buttons.right)  io.MouseDown[1] = false;
-        if (io.MouseDown[2] && !mouse.buttons.middle) io.MouseDown[2] = false;
+        mouse_x = mouse.x / display.width();
+        mouse_y = mouse.y / display.height();
     }
 
-    virtual void onMouseMove(PixelToaster::DisplayInterface& display, PixelToaster::Mouse mouse) override final
+    static unsigned pressed(const PixelToaster::Mouse& mouse)
     {
-        auto& io = ImGui::GetIO();
-        io.MousePos.x = mouse.x * imgui_render_target->width / display.width();
-        io.MousePos.y = mouse.y * imgui_render_target->height / display.height();
+        return (mouse.buttons.left ? 1 : 0) | (mouse.buttons.right ? 2 : 0) | (mouse.buttons.middle ? 4 : 0);
     }
 };
 
@@ -485,15 +157,11 @@ int wmain()
 
     float displayScale = 1.0f;
 
-    pt::Display display("ASCII Renderer", static_cast<int>(1440 * displayScale), static_cast<int>(800 * displayScale));
     imgui_listener listener;
-    display.listener(&listener);
-
-    display.zoom(2);
 
     pt::Timer timer;
 
-    toaster_framebuffer_t display_buffer(display);
+    toaster_framebuffer_t display_buffer("ASCII Renderer", static_cast<int>(1440 * displayScale), static_cast<int>(800 * displayScale), 2, &listener);
 
     const auto ascii_font_5x7  = ascii_font_t{ get_font_5x7(),  " .',\";o%O8@#", 1 };
     const auto ascii_font_8x8  = ascii_font_t{ get_font_8x8(),  " .',\";o%O8@#", 0 };
@@ -502,29 +170,12 @@ int wmain()
     auto& font         = get_font_8x8();
     auto  ascii_buffer = ascii_framebuffer_t(display_buffer, ascii_font_8x8);
 
-    std::vector<transformed_vertex_t> vertices;
-
-    struct object_t
-    {
-        mesh_t  mesh;
-        matrix4 transformation;
-    };
-
-    object_t torus  = { make_torus(10, 5, 24, 16), matrix4::identity };
-    object_t box    = { make_box(15, 15, 15),      matrix4::identity };
-    object_t teapot = { make_teapot(5, 4),         matrix4::identity };
-    object_t line   = { make_line(-19.0f, 0.0f, 0.0f, 19.0f, 0.0f, 0.0f), matrix4::identity };
-    object_t normal = { make_normals(teapot.mesh, 0.350f), matrix4::identity };
+    tile_rasterizer_t rasterizer;
+    scene_t           scene;
+    scene_options_t   options;
 
-    object_t* objects[] =
-    {
-        &torus,
-        &box,
-        &teapot,
-        &line,
-        &normal,
-    };
-    int object_count = sizeof(objects) / sizeof(*objects);
+    // Recording must never slow down the window, frames are dropped when disk lags
+    std::optional<frame_writer_t> recorder;
 
     image_t font_atlas = {};
     {
@@ -547,18 +198,17 @@ int wmain()
     bool pause                = false;
     bool use_ascii_buffer     = false;
     bool dither_ascii_buffer  = false;
+    int  dither_pattern       = 0;
+    bool diff_ascii_cells     = true;
     bool dither_with_z_buffer = false;
-    bool solid                = true;
-    bool lines                = true;
-    bool wireframe            = false;
-    bool wireframe_2d         = false;
-    float angle               = 0.0f;
-    float scale               = 1.0f;
     int  current_font         = 1;
+    int  current_depth_format = 0;
+    int  current_present      = 0;
+    bool record               = false;
 
     timer.reset();
     float time = 0.0f;
-    while (display.open())
+    while (display_buffer.open())
     {
         auto deltaTime = static_cast<float>(timer.delta());
 
@@ -569,6 +219,7 @@ int wmain()
         io.DisplaySize.x = static_cast<float>(imgui_render_target->width);
         io.DisplaySize.y = static_cast<float>(imgui_render_target->height);
         io.DeltaTime     = deltaTime;
+        listener.apply(io);
 
         ImGui::NewFrame();
 
@@ -578,281 +229,15 @@ int wmain()
         const float window_h      = (float)display_buffer.height;
         const float window_aspect = window_w / window_h;
 
-        const viewport_t viewport =
-        {
-            0.0f,//buffer.width,
-            -buffer.height / 2.0f,
-            (float)buffer.width / 2,
-            (float)buffer.height / 2,
-            0.0f,
-            1.0f,
-        };
-
-        const auto view       = matrix4::lookAtLH(vec3(0, -50, 0), vec3(0, 0, 0), vec3(0, 0, 1));
-        const auto projection = matrix4::perspectiveFovLH((float)M_PI / 8.0f, window_aspect, 1.0f, 500.0f);
-
         buffer.clear(0, 1.0f);
 
-        torus.transformation =
-            matrix4::scale(scale, scale, scale) *
-            //matrix4::rotationYawPitchRoll(time - 1, time * 0.1f, 0) *
-            matrix4::rotationYawPitchRoll(time, time * 0.4f, time * -0.25f) *
-            matrix4::identity;
-        torus.transformation[12] = -20;// * sinf(time * 1.25f);
-        torus.transformation = torus.transformation *
-            matrix4::rotationYawPitchRoll(0.0f, 0.0f, angle);
-
-        box.transformation =
-            matrix4::scale(scale, scale, scale) *
-            matrix4::rotationYawPitchRoll(time + 1, -time * 0.2f, time * -0.35f) *
-            matrix4::identity;
-        box.transformation[12]   =  20;// * sinf(time * 1.25f);
-        box.transformation = box.transformation *
-            matrix4::rotationYawPitchRoll(0.0f, 0.0f, angle);
-
-        teapot.transformation =
-            matrix4::scale(scale, scale, scale) *
-            matrix4::translation(0, 0, -4) *
-            matrix4::rotationYawPitchRoll(time - 1, time * 0.1f, time * 0.45f) *
-            matrix4::translation(0, 0, 0) *
-            matrix4::rotationYawPitchRoll(0.0f, 0.0f, angle);
-
-        //teapot.transformation =
-        //    matrix4::scale(scale, scale, scale) *
-        //    matrix4::translation(0, 0, -6) *
-        //    matrix4::rotationYawPitchRoll(time - 1, time * 0.1f, time * 0.45f) *
-        //    matrix4::rotationYawPitchRoll(0, 0, angle + time * 0.45f) *
-        //    //matrix4::rotationYawPitchRoll(0.0f, 0.0f, angle + time * 0.45f) *
-        //    matrix4::translation(0, -16, 0);
-
-        line.transformation =
-            //matrix4::translation(0, 0, 0) *
-            //matrix4::rotationYawPitchRoll(time - 1, time * 0.1f, time * 0.45f) *
-            //matrix4::rotationYawPitchRoll(0.0f, 0.0f, time * 0.45f) *
-            //matrix4::translation(0, 0, 0) *
-            torus.transformation;
-
-        normal.transformation =
-            //matrix4::translation(0, 0, 0) *
-            //matrix4::rotationYawPitchRoll(time - 1, time * 0.1f, time * 0.45f) *
-            //matrix4::rotationYawPitchRoll(0.0f, 0.0f, time * 0.45f) *
-            //matrix4::translation(0, 0, 0) *
-            teapot.transformation;
-
-        const auto camera_transformation = view * projection;
-
-        const auto clip_transformation = matrix4::clip(
-            viewport.clipX, viewport.clipY, viewport.clipWidth, viewport.clipHeight, viewport.minZ, viewport.maxZ);
-
-        const auto viewport_scale =
-            matrix4::translation(1.0f, -1.0f, 0.0f) *
-            matrix4::scale(0.5f * buffer.width, -0.5f * buffer.height, 1.0f)
-            ;
-
-
-        for (int i = 0; i < object_count; ++i)
-        {
-            auto& object = *objects[i];
-
-            const auto& indices  = object.mesh.indices;
-            vertices.reserve(object.mesh.vertices.size());
-            vertices.resize(0);
-
-            const auto transformation = object.transformation * camera_transformation * clip_transformation;
-            const auto transposed     = (object.transformation * view).transposed();
-
-            for (auto& vertex : object.mesh.vertices)
-            {
-                transformed_vertex_t v;
-                v.p = vec4(vertex.p, 1.0f).transformed(transformation);
-                v.n = vertex.n.transformed_vector(object.transformation).normalized();
-                v.c = vertex.c;
-
-                vertices.push_back(v);
-            }
-
-            float minZ = 1.0f;
-            float maxZ = 0.0f;
-# if 0
-            for (auto& vtx : vertices)
-            {
-                minZ = std::min(minZ, vtx.p.z);
-                maxZ = std::max(maxZ, vtx.p.z);
-
-                //buffer.set(vtx.p.x, vtx.p.y, 1.0f);
-            }
-# else
-            minZ = 0.96f;
-            maxZ = 0.99f;
-# endif
-
-            if (solid && object.mesh.primitive_type == primitive_type_t::triangle_list)
-            {
-                for (int i = 0; i < (int)indices.size() / 3; ++i)
-                {
-                    auto i0 = indices[i * 3 + 0], i1 = indices[i * 3 + 1], i2 = indices[i * 3 + 2];
-
-                    const auto clip = true;
-
-                    const transformed_triangle_t triangle = { vertices[i0], vertices[i1], vertices[i2] };
-                    triangle_clip_result_t clipped_triangles;
-                    if (clip)
-                        clip_triangle(triangle, clipped_triangles);
-
-                    const auto& triangles      = clip ? &clipped_triangles.triangles[0]  : &triangle;
-                    const auto& triangle_count = clip ? clipped_triangles.triangle_count : 1;
-
-                    for (int triangle_index = 0; triangle_index < triangle_count; ++triangle_index)
-                    {
-                        const auto& triangle = triangles[triangle_index];
+        if (use_ascii_buffer)
+            rasterizer.begin(ascii_buffer);
+        else
+            rasterizer.begin(display_buffer);
 
-                        const auto& v0 = triangle.a;
-                        const auto& v1 = triangle.b;
-                        const auto& v2 = triangle.c;
-
-                        //if (cross(v0.p.xy() - v1.p.xy(), v0.p.xy() - v2.p.xy()) < 0)
-                        //    continue;
-
-                        //const auto t0 = (-v0.p.w < v0.p.x) && (v0.p.x <= v0.p.w) && (-v0.p.w < v0.p.y) && (v0.p.y <= v0.p.w) && (0.0f < v0.p.z) && (v0.p.z <= v0.p.w);
-                        //const auto t1 = (-v1.p.w < v1.p.x) && (v1.p.x <= v1.p.w) && (-v1.p.w < v1.p.y) && (v1.p.y <= v1.p.w) && (0.0f < v1.p.z) && (v1.p.z <= v1.p.w);
-                        //const auto t2 = (-v2.p.w < v2.p.x) && (v2.p.x <= v2.p.w) && (-v2.p.w < v2.p.y) && (v2.p.y <= v2.p.w) && (0.0f < v2.p.z) && (v2.p.z <= v2.p.w);
-
-                        //if (!t0 || !t1 || !t2)
-                        //    continue;
-
-                        const auto p0 = v0.p.transformed(viewport_scale);
-                        const auto p1 = v1.p.transformed(viewport_scale);
-                        const auto p2 = v2.p.transformed(viewport_scale);
-
-                        const auto o0 = vec3(p0.x / p0.w, p0.y / p0.w, p0.z / p0.w);
-                        const auto o1 = vec3(p1.x / p1.w, p1.y / p1.w, p1.z / p1.w);
-                        const auto o2 = vec3(p2.x / p2.w, p2.y / p2.w, p2.z / p2.w);
-
-                        if (cross(o0 - o1, o0 - o2).z < 0)
-                            continue;
-
-                        //const auto c0 = 1.0f - (o0.z - minZ) / (maxZ - minZ);
-                        //const auto c1 = 1.0f - (o1.z - minZ) / (maxZ - minZ);
-                        //const auto c2 = 1.0f - (o2.z - minZ) / (maxZ - minZ);
-
-                        const auto c0 = std::max(v0.n.dot(vec3(5, 0, 10).normalized()) * 0.5f + 0.5f, 0.0f);
-                        const auto c1 = std::max(v1.n.dot(vec3(5, 0, 10).normalized()) * 0.5f + 0.5f, 0.0f);
-                        const auto c2 = std::max(v2.n.dot(vec3(5, 0, 10).normalized()) * 0.5f + 0.5f, 0.0f);
-
-                        generic_triangle_3d(buffer,
-                            o1.x, o1.y, o1.z,
-                            o0.x, o0.y, o0.z,
-                            o2.x, o2.y, o2.z,
-                            c1, c0, c2);
-                    }
-                }
-            }
-
-            if (object.mesh.primitive_type == primitive_type_t::triangle_list)
-            {
-                for (int i = 0; i < (int)indices.size() / 3; ++i)
-                {
-                    auto i0 = indices[i * 3 + 0], i1 = indices[i * 3 + 1], i2 = indices[i * 3 + 2];
-
-                    const auto& v0 = vertices[i0];
-                    const auto& v1 = vertices[i1];
-                    const auto& v2 = vertices[i2];
-
-                    const auto p0 = v0.p.transformed(viewport_scale);
-                    const auto p1 = v1.p.transformed(viewport_scale);
-                    const auto p2 = v2.p.transformed(viewport_scale);
-
-                    const auto o0 = vec3(p0.x / p0.w, p0.y / p0.w, p0.z / p0.w);
-                    const auto o1 = vec3(p1.x / p1.w, p1.y / p1.w, p1.z / p1.w);
-                    const auto o2 = vec3(p2.x / p2.w, p2.y / p2.w, p2.z / p2.w);
-
-                    if (cross(o0 - o1, o0 - o2).z < 0)
-                        continue;
-
-                    //const auto c0 = 1.0f - (v0.p.z - minZ) / (maxZ - minZ);
-                    //const auto c1 = 1.0f - (v1.p.z - minZ) / (maxZ - minZ);
-                    //const auto c2 = 1.0f - (v2.p.z - minZ) / (maxZ - minZ);
-
-                    const auto c0 = std::max(v0.n.dot(vec3(5, 0, 10).normalized()) * 0.5f + 0.5f, 0.0f);
-                    const auto c1 = std::max(v1.n.dot(vec3(5, 0, 10).normalized()) * 0.5f + 0.5f, 0.0f);
-                    const auto c2 = std::max(v2.n.dot(vec3(5, 0, 10).normalized()) * 0.5f + 0.5f, 0.0f);
-
-                    if (wireframe)
-                    {
-                        generic_line_3d(buffer,
-                            o1.x, o1.y, o1.z,
-                            o0.x, o0.y, o0.z,
-                            c1, c0);
-
-                        generic_line_3d(buffer,
-                            o1.x, o1.y, o1.z,
-                            o2.x, o2.y, o2.z,
-                            c1, c2);
-
-                        generic_line_3d(buffer,
-                            o0.x, o0.y, o0.z,
-                            o2.x, o2.y, o2.z,
-                            c0, c2);
-                    }
-
-                    if (wireframe_2d)
-                    {
-                        generic_line_2d(buffer,
-                            static_cast<int>(o1.x), static_cast<int>(o1.y),
-                            static_cast<int>(o0.x), static_cast<int>(o0.y),
-                            (c1 + c0) * 0.5f);
-
-                        generic_line_2d(buffer,
-                            static_cast<int>(o1.x), static_cast<int>(o1.y),
-                            static_cast<int>(o2.x), static_cast<int>(o2.y),
-                            (c1 + c2) * 0.5f);
-
-                        generic_line_2d(buffer,
-                            static_cast<int>(o0.x), static_cast<int>(o0.y),
-                            static_cast<int>(o2.x), static_cast<int>(o2.y),
-                            (c0 + c2) * 0.5f);
-                    }
-                }
-            }
-
-            if (object.mesh.primitive_type == primitive_type_t::line_list)
-            {
-                auto invertedTransformation = (object.transformation * camera_transformation).inverted();
-
-                for (int i = 0; i < (int)indices.size() / 2; ++i)
-                {
-                    auto i0 = indices[i * 2 + 0], i1 = indices[i * 2 + 1];
-
-                    const auto& v0 = vertices[i0];
-                    const auto& v1 = vertices[i1];
-
-                    const auto p0 = v0.p.transformed(viewport_scale);
-                    const auto p1 = v1.p.transformed(viewport_scale);
-
-                    const auto o0 = vec3(p0.x / p0.w, p0.y / p0.w, p0.z / p0.w);
-                    const auto o1 = vec3(p1.x / p1.w, p1.y / p1.w, p1.z / p1.w);
-
-                    const auto c0 = 1.0f;// - (v0.p.z - minZ) / (maxZ - minZ);
-                    const auto c1 = 1.0f;// - (v1.p.z - minZ) / (maxZ - minZ);
-
-                    if (lines || wireframe)
-                    {
-                        generic_line_3d(buffer,
-                            o1.x, o1.y, o1.z,
-                            o0.x, o0.y, o0.z,
-                            c1, c0);
-                    }
-
-                    if (wireframe_2d)
-                    {
-                        generic_line_2d(buffer,
-                            static_cast<int>(o1.x), static_cast<int>(o1.y),
-                            static_cast<int>(o0.x), static_cast<int>(o0.y),
-                            (c1 + c0) * 0.5f);
-                    }
-                }
-            }
-        }
+        scene.animate(time, options);
+        scene.draw(buffer, rasterizer, window_aspect, options);
 
         //for (auto& vtx : vertices)
         //    buffer.set(vtx.p.x, vtx.p.y, 1.0f);
@@ -879,7 +264,16 @@ int wmain()
         //char_2d(buffer, f, 5, 21, index, 1);
 
         if (use_ascii_buffer && dither_ascii_buffer)
-            ascii_buffer.dither(dither_with_z_buffer);
+        {
+            if (dither_pattern == 0)
+                ascii_buffer.dither(dither_with_z_buffer);
+            else if (dither_pattern < 5)
+                ascii_buffer.dither_ordered(get_bayer_mask(1 << dither_pattern));
+            else
+                ascii_buffer.dither_ordered(get_blue_noise_mask());
+        }
+
+        ascii_buffer.diff_cells = diff_ascii_cells;
 
         buffer.commit();
 
@@ -900,21 +294,52 @@ int wmain()
                     case 1: new (&ascii_buffer) ascii_framebuffer_t(display_buffer, ascii_font_8x8);  break;
                     case 2: new (&ascii_buffer) ascii_framebuffer_t(display_buffer, ascii_font_8x13); break;
                 }
+                ascii_buffer.set_depth_format(static_cast<depth_format_t>(current_depth_format));
+            }
+
+            if (ImGui::Combo("Depth", &current_depth_format, "float32\0unorm24\0unorm16\0\0"))
+            {
+                display_buffer.set_depth_format(static_cast<depth_format_t>(current_depth_format));
+                ascii_buffer.set_depth_format(static_cast<depth_format_t>(current_depth_format));
             }
 
+            if (ImGui::Combo("Present", &current_present, "block\0drop late frames\0\0"))
+                display_buffer.queue.policy = current_present ? present_policy_t::drop : present_policy_t::block;
+
+            if (ImGui::Checkbox("Record to capture.y4m", &record))
+            {
+                display_buffer.capture = nullptr;
+                recorder.reset();
+
+                if (record)
+                {
+                    recorder.emplace("capture.y4m", frame_format_t::y4m, display_buffer.width, display_buffer.height, 60, 8, present_policy_t::drop);
+                    display_buffer.capture = &*recorder;
+                }
+            }
+
+            if (recorder)
+                ImGui::Text("Recorded %d frames, dropped %d", recorder->written_frames(), recorder->dropped_frames());
+
             ImGui::Spacing();
 
-            ImGui::Checkbox("Render to ASCII buffer", &use_ascii_buffer);
+            // Pixels rendered meanwhile are over the cells
+            if (ImGui::Checkbox("Render to ASCII buffer", &use_ascii_buffer))
+                ascii_buffer.invalidate();
             ImGui::Checkbox("Dither ASCII buffer", &dither_ascii_buffer);
+            ImGui::Checkbox("Draw changed ASCII cells only", &diff_ascii_cells);
+            if (use_ascii_buffer)
+                ImGui::Text("ASCII cells drawn: %d of %d", ascii_buffer.changed_cells, ascii_buffer.width * ascii_buffer.height);
             ImGui::Checkbox("Dither with Z-buffer", &dither_with_z_buffer);
+            ImGui::Combo("Dither pattern", &dither_pattern, "error diffusion\0Bayer 2x2\0Bayer 4x4\0Bayer 8x8\0Bayer 16x16\0blue noise\0\0");
             ImGui::Spacing();
-            ImGui::Checkbox("Solid", &solid);
-            ImGui::Checkbox("Lines", &lines);
-            ImGui::Checkbox("Wireframe", &wireframe);
-            ImGui::Checkbox("Wireframe (2D)", &wireframe_2d);
+            ImGui::Checkbox("Solid", &options.solid);
+            ImGui::Checkbox("Lines", &options.lines);
+            ImGui::Checkbox("Wireframe", &options.wireframe);
+            ImGui::Checkbox("Wireframe (2D)", &options.wireframe_2d);
             ImGui::Spacing();
-            ImGui::SliderAngle("Angle", &angle, -180.0f, 180.0f);
-            ImGui::DragFloat("Scale", &scale, 0.01f, 0.1f, 4.0f);
+            ImGui::SliderAngle("Angle", &options.angle, -180.0f, 180.0f);
+            ImGui::DragFloat("Scale", &options.scale, 0.01f, 0.1f, 4.0f);
             ImGui::Spacing();
             ImGui::Checkbox("Pause", &pause);
         }
@@ -922,6 +347,9 @@ int wmain()
 
         ImGui::Render();
 
+        // Overlay is drawn over cells, next commit has to restore them
+        ascii_buffer.invalidate(imgui_drawn);
+
         buffer.present();
     }
 }
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "headless_framebuffer.h"
+#include "toaster_framebuffer.h"
+#include "ascii_framebuffer.h"
+#include "scene.h"
+#include "frame_writer.h"
+#include "tile_rasterizer.h"
+
+#include <vector>
+#include <optional>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Renders the demo scene without a window. Frames go to memory, to PGM/PPM
+// stills or Y4M stream, optionally through toaster_framebuffer_t and its
+// present thread to the null display.
+//
+//   offscreen -frames 120 -size 1920x1080 -ascii 8x8 -dither -o out/frame_
+//   offscreen -frames 600 -format y4m -o scene.y4m
+
+struct offscreen_options_t
+{
+    int             frames       = 60;
+    int             width        = 1440;
+    int             height       = 800;
+    float           fps          = 30.0f;
+    int             ascii_font   = -1;          // index to ascii_font_names, -1 renders pixels
+    bool            dither       = false;
+    bool            dither_depth = false;
+    int             dither_mask  = -1;          // index to dither_mask_names, -1 diffuses error
+    bool            diff_cells   = true;
+    depth_format_t  depth_format = depth_format_t::float32;
+    bool            toaster      = false;
+    bool            keep         = false;
+    const char*     output       = nullptr;
+    frame_format_t  format       = frame_format_t::pgm;
+    scene_options_t scene;
+};
+
+static const char* const ascii_font_names[] = { "5x7", "8x8", "8x13" };
+static const char* const dither_mask_names[] = { "bayer2", "bayer4", "bayer8", "bayer16", "blue" };
+static const char* const depth_format_names[] = { "float32", "unorm24", "unorm16" };
+static const char* const frame_format_names[] = { "pgm", "ppm", "y4m" };
+
+static ascii_font_t ascii_font(int index)
+{
+    switch (index)
+    {
+        case 0:  return { get_font_5x7(),  " .',\";o%O8@#", 1 };
+        default:
+        case 1:  return { get_font_8x8(),  " .',\";o%O8@#", 0 };
+        case 2:  return { get_font_8x13(), " .',;\"o#@%O8", 0 };
+    }
+}
+
+// Hashes every frame, optionally keeps copies in memory and passes frames on
+// to the writer.
+struct offscreen_sink_t final: frame_sink_t
+{
+    frame_sink_t*                     next;
+    bool                              keep;
+    std::vector<std::vector<uint8_t>> frames;
+    uint64_t                          checksum = 14695981039346656037ull;
+
+    offscreen_sink_t(frame_sink_t* next, bool keep):
+        next(next),
+        keep(keep)
+    {
+    }
+
+    virtual void frame(const uint8_t* pixels, int width, int height, const rect_t& dirty) override final
+    {
+        const auto size = static_cast<size_t>(width) * height;
+
+        // FNV-1a
+        for (size_t i = 0; i < size; ++i)
+            checksum = (checksum ^ pixels[i]) * 1099511628211ull;
+
+        if (keep)
+            frames.emplace_back(pixels, pixels + size);
+
+        if (next)
+            next->frame(pixels, width, height, dirty);
+    }
+};
+
+// Returns share of ASCII cells drawn again per frame.
+template <typename target_t>
+static double render(target_t& target, const offscreen_options_t& options)
+{
+    tile_rasterizer_t rasterizer;
+    scene_t           scene;
+
+    target.set_depth_format(options.depth_format);
+
+    std::optional<ascii_framebuffer_t> ascii;
+    if (options.ascii_font >= 0)
+    {
+        ascii.emplace(target, ascii_font(options.ascii_font));
+        ascii->set_depth_format(options.depth_format);
+        ascii->diff_cells = options.diff_cells;
+    }
+
+    double changed_cells = 0;
+
+    auto& buffer = ascii ? static_cast<framebuffer_t&>(*ascii) : static_cast<framebuffer_t&>(target);
+
+    const auto aspect = static_cast<float>(target.width) / static_cast<float>(target.height);
+
+    for (int frame = 0; frame < options.frames; ++frame)
+    {
+        const auto time = frame / options.fps;
+
+        buffer.clear(0, 1.0f);
+
+        if (ascii)
+            rasterizer.begin(*ascii);
+        else
+            rasterizer.begin(target);
+
+        scene.animate(time, options.scene);
+        scene.draw(buffer, rasterizer, aspect, options.scene);
+
+        if (ascii && options.dither_mask >= 0)
+            ascii->dither_ordered(options.dither_mask < 4 ? get_bayer_mask(2 << options.dither_mask) : get_blue_noise_mask());
+        else if (ascii && options.dither)
+            ascii->dither(options.dither_depth);
+
+        buffer.commit();
+        buffer.present();
+
+        if (ascii)
+            changed_cells += static_cast<double>(ascii->changed_cells) / (ascii->width * ascii->height);
+    }
+
+    return options.frames ? changed_cells / options.frames : 0.0;
+}
+
+static int find_name(const char* name, const char* const* names, int count)
+{
+    for (int i = 0; i < count; ++i)
+        if (strcmp(name, names[i]) == 0)
+            return i;
+
+    return -1;
+}
+
+static void print_usage()
+{
+    fprintf(stderr,
+        "usage: offscreen [options]\n"
+        "  -frames N        number of frames to render (60)\n"
+        "  -size WxH        framebuffer size (1440x800)\n"
+        "  -fps F           animation frames per second (30)\n"
+        "  -ascii FONT      render ASCII cells, font 5x7, 8x8 or 8x13\n"
+        "  -dither          dither ASCII cells\n"
+        "  -dither-depth    dither with depth buffer weights\n"
+        "  -ordered MASK    dither with bayer2, bayer4, bayer8, bayer16 or blue noise mask\n"
+        "  -full-commit     draw every ASCII cell, not only changed ones\n"
+        "  -depth FORMAT    float32, unorm24 or unorm16 (float32)\n"
+        "  -wireframe       draw wireframe over solid triangles\n"
+        "  -o PATH          write frames to PATH00000.pgm, PATH00001.pgm, ...\n"
+        "                   or to PATH as single stream for y4m\n"
+        "  -format FORMAT   pgm, ppm or y4m (pgm)\n"
+        "  -keep            keep frames in memory\n"
+        "  -toaster         present through toaster_framebuffer_t to the null display\n");
+}
+
+static bool parse_options(int argc, char** argv, offscreen_options_t& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto arg   = argv[i];
+        const auto value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "-frames") == 0 && value)
+            options.frames = atoi(argv[++i]);
+        else if (strcmp(arg, "-size") == 0 && value)
+        {
+            if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2)
+                return false;
+        }
+        else if (strcmp(arg, "-fps") == 0 && value)
+            options.fps = static_cast<float>(atof(argv[++i]));
+        else if (strcmp(arg, "-ascii") == 0 && value)
+        {
+            options.ascii_font = find_name(argv[++i], ascii_font_names, 3);
+            if (options.ascii_font < 0)
+                return false;
+        }
+        else if (strcmp(arg, "-dither") == 0)
+            options.dither = true;
+        else if (strcmp(arg, "-dither-depth") == 0)
+            options.dither = options.dither_depth = true;
+        else if (strcmp(arg, "-ordered") == 0 && value)
+        {
+            options.dither_mask = find_name(argv[++i], dither_mask_names, 5);
+            if (options.dither_mask < 0)
+                return false;
+        }
+        else if (strcmp(arg, "-full-commit") == 0)
+            options.diff_cells = false;
+        else if (strcmp(arg, "-depth") == 0 && value)
+        {
+            const auto format = find_name(argv[++i], depth_format_names, 3);
+            if (format < 0)
+                return false;
+            options.depth_format = static_cast<depth_format_t>(format);
+        }
+        else if (strcmp(arg, "-wireframe") == 0)
+            options.scene.wireframe = true;
+        else if (strcmp(arg, "-o") == 0 && value)
+            options.output = argv[++i];
+        else if (strcmp(arg, "-format") == 0 && value)
+        {
+            const auto format = find_name(argv[++i], frame_format_names, 3);
+            if (format < 0)
+                return false;
+            options.format = static_cast<frame_format_t>(format);
+        }
+        else if (strcmp(arg, "-keep") == 0)
+            options.keep = true;
+        else if (strcmp(arg, "-toaster") == 0)
+            options.toaster = true;
+        else
+            return false;
+    }
+
+    return options.frames >= 0 && options.width > 0 && options.height > 0 && options.fps > 0.0f;
+}
+
+int main(int argc, char** argv)
+{
+    offscreen_options_t options;
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage();
+        return 1;
+    }
+
+    std::optional<frame_writer_t> writer;
+    if (options.output)
+        writer.emplace(options.output, options.format, options.width, options.height, static_cast<int>(options.fps + 0.5f));
+
+    offscreen_sink_t sink(writer ? &*writer : nullptr, options.keep);
+
+    double changed_cells = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    if (options.toaster)
+    {
+        toaster_framebuffer_t target("offscreen", options.width, options.height, 1, nullptr);
+        target.capture = &sink;
+        changed_cells = render(target, options);
+    }
+    else
+    {
+        headless_framebuffer_t target(options.width, options.height, &sink);
+        changed_cells = render(target, options);
+    }
+
+    const auto render_end = std::chrono::steady_clock::now();
+
+    if (writer)
+        writer->close();
+
+    const auto end = std::chrono::steady_clock::now();
+
+    const auto render_seconds = std::chrono::duration<double>(render_end - start).count();
+    const auto flush_seconds  = std::chrono::duration<double>(end - render_end).count();
+
+    printf("%d frames, %dx%d, %.3f ms/frame\n", options.frames, options.width, options.height, options.frames ? 1000.0 * render_seconds / options.frames : 0.0);
+    printf("checksum %016llx\n", static_cast<unsigned long long>(sink.checksum));
+    if (options.ascii_font >= 0)
+        printf("%.1f%% cells drawn per frame\n", 100.0 * changed_cells);
+    if (options.keep)
+        printf("%d frames kept in memory\n", static_cast<int>(sink.frames.size()));
+    if (writer)
+        printf("%d frames written, %.3f ms waiting for disk after last frame\n", writer->written_frames(), 1000.0 * flush_seconds);
+
+    return writer && writer->failed() ? 1 : 0;
+}
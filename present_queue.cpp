@@ -0,0 +1,138 @@
+#include "present_queue.h"
+#include <algorithm>
+
+present_queue_t::present_queue_t(int slot_count, present_policy_t policy):
+    policy(policy),
+    count(std::clamp(slot_count, 2, max_slots)),
+    carried{ 0, 0, 0, 0 }
+{
+    for (auto& state : states)
+        state = state_free;
+
+    for (auto& dirty : dirty_rects)
+        dirty = { 0, 0, 0, 0 };
+}
+
+int present_queue_t::acquire()
+{
+    for (;;)
+    {
+        // Counter is read before looking at slots, so release in between is not missed
+        const auto seen = released.load();
+
+        if (closed)
+            return -1;
+
+        for (int i = 0; i < count; ++i)
+        {
+            if (states[i] == state_free)
+            {
+                states[i] = state_rendering;
+                return i;
+            }
+        }
+
+        // No spare buffer, frame waiting for present gets overwritten
+        int slot;
+        if (policy == present_policy_t::drop && reclaim_ready(slot))
+            return slot;
+
+        released.wait(seen);
+    }
+}
+
+void present_queue_t::publish(int slot, const rect_t& dirty)
+{
+    if (policy == present_policy_t::block)
+    {
+        // Waiting frame has to be taken first
+        for (;;)
+        {
+            const auto seen = released.load();
+
+            if (closed || std::none_of(states, states + count, [](const std::atomic<int>& state) { return state == state_ready; }))
+                break;
+
+            released.wait(seen);
+        }
+    }
+    else
+    {
+        int dropped;
+        if (reclaim_ready(dropped))
+            states[dropped] = state_free;
+    }
+
+    dirty_rects[slot] = merge_rects(carried, dirty);
+    carried = { 0, 0, 0, 0 };
+
+    states[slot] = state_ready;
+
+    ++published;
+    published.notify_one();
+}
+
+bool present_queue_t::take(int& slot, rect_t& dirty)
+{
+    for (;;)
+    {
+        const auto seen = published.load();
+
+        if (closed)
+            return false;
+
+        for (int i = 0; i < count; ++i)
+        {
+            auto expected = static_cast<int>(state_ready);
+            if (states[i].compare_exchange_strong(expected, state_presenting))
+            {
+                slot  = i;
+                dirty = dirty_rects[i];
+
+                ++released;
+                released.notify_one();
+
+                return true;
+            }
+        }
+
+        published.wait(seen);
+    }
+}
+
+void present_queue_t::release(int slot)
+{
+    states[slot] = state_free;
+
+    ++released;
+    released.notify_one();
+}
+
+void present_queue_t::close()
+{
+    closed = true;
+
+    ++published;
+    published.notify_all();
+
+    ++released;
+    released.notify_all();
+}
+
+// Takes waiting frame back to render thread, unless present thread got it
+// first. Its dirty rectangle is carried to the next published frame.
+bool present_queue_t::reclaim_ready(int& slot)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        auto expected = static_cast<int>(state_ready);
+        if (states[i].compare_exchange_strong(expected, state_rendering))
+        {
+            carried = merge_rects(carried, dirty_rects[i]);
+            slot    = i;
+            return true;
+        }
+    }
+
+    return false;
+}
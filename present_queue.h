@@ -0,0 +1,63 @@
+#pragma once
+#include "drawing.h"
+#include <atomic>
+
+// What render thread does when present thread is still busy with older frame.
+enum class present_policy_t
+{
+    block,      // wait, every frame gets presented
+    drop        // replace frame waiting for present with the newer one
+};
+
+// Lock-free handoff of finished frames from render thread to present thread.
+// Frames live in 'slot_count' buffers owned by the user, queue tracks which
+// one is rendered, waiting and presented. At most one frame waits at a time.
+//
+// Dirty rectangle of a frame is relative to the previous frame. Rectangles of
+// dropped frames are carried over, so take() returns everything changed since
+// last presented frame.
+struct present_queue_t
+{
+    static constexpr int max_slots = 3;
+
+    explicit present_queue_t(int slot_count = max_slots, present_policy_t policy = present_policy_t::drop);
+
+    present_queue_t(const present_queue_t&) = delete;
+    present_queue_t& operator=(const present_queue_t&) = delete;
+
+    int slot_count() const { return count; }
+
+    // Policy can be changed from any thread, it applies to next publish/acquire.
+    std::atomic<present_policy_t> policy;
+
+    // Render thread. Slot returned by acquire() belongs to caller until it is
+    // published. Returns -1 if queue is closed.
+    int  acquire();
+    void publish(int slot, const rect_t& dirty);
+
+    // Present thread. Waits for next frame, false once queue is closed.
+    bool take(int& slot, rect_t& dirty);
+    void release(int slot);
+
+    // Wakes both threads, take() and acquire() fail from now on.
+    void close();
+
+private:
+    enum state_t
+    {
+        state_free,
+        state_rendering,
+        state_ready,
+        state_presenting
+    };
+
+    bool reclaim_ready(int& slot);
+
+    int                     count;
+    std::atomic<int>        states[max_slots];
+    rect_t                  dirty_rects[max_slots];
+    rect_t                  carried;            // render thread only
+    std::atomic<unsigned>   published { 0 };    // bumped to wake present thread
+    std::atomic<unsigned>   released  { 0 };    // bumped to wake render thread
+    std::atomic<bool>       closed    { false };
+};
@@ -0,0 +1,452 @@
+#define _USE_MATH_DEFINES
+#include "scene.h"
+#include <algorithm>
+#include <cfloat>
+#include <iterator>
+
+struct transformed_triangle_t
+{
+    transformed_vertex_t a{}, b{}, c{};
+};
+
+// Clip planes are pushed out by guard band factors on x/y, so only triangles
+// reaching far off screen get clipped there. Rasterizer scissors the rest.
+struct guard_band_t
+{
+    float x, y;
+};
+
+// Bits set for planes vertex is outside of. Screen planes only reject, never clip.
+enum clip_plane_t
+{
+    clip_plane_right   = 1 << 0,    // x <= gx * w
+    clip_plane_top     = 1 << 1,    // y <= gy * w
+    clip_plane_far     = 1 << 2,    // z <= w
+    clip_plane_left    = 1 << 3,    // -gx * w < x
+    clip_plane_bottom  = 1 << 4,    // -gy * w < y
+    clip_plane_near    = 1 << 5,    // 0 < z
+    clip_plane_all     = (1 << 6) - 1,
+
+    screen_plane_right  = 1 << 6,   // x <= w
+    screen_plane_top    = 1 << 7,   // y <= w
+    screen_plane_left   = 1 << 8,   // -w < x
+    screen_plane_bottom = 1 << 9,   // -w < y
+};
+
+static int clip_outcode(const vec4& p, const guard_band_t& band)
+{
+    return
+        (p.x <= band.x * p.w  ? 0 : clip_plane_right)    |
+        (p.y <= band.y * p.w  ? 0 : clip_plane_top)      |
+        (p.z <= p.w           ? 0 : clip_plane_far)      |
+        (-band.x * p.w < p.x  ? 0 : clip_plane_left)     |
+        (-band.y * p.w < p.y  ? 0 : clip_plane_bottom)   |
+        (0.0f < p.z           ? 0 : clip_plane_near)     |
+        (p.x <= p.w           ? 0 : screen_plane_right)  |
+        (p.y <= p.w           ? 0 : screen_plane_top)    |
+        (-p.w < p.x           ? 0 : screen_plane_left)   |
+        (-p.w < p.y           ? 0 : screen_plane_bottom);
+}
+
+// Convex polygon, every clip plane adds at most one vertex to a triangle.
+struct clip_polygon_t
+{
+    transformed_vertex_t vertices[3 + 6];
+    int                  vertex_count = 0;
+};
+
+// Sutherland-Hodgman, clips triangle against planes selected by 'planes' (see clip_plane_t).
+static void clip_triangle(const transformed_triangle_t& triangle, int planes, const guard_band_t& band, clip_polygon_t& result)
+{
+    struct clip_rule_t
+    {
+        using test_t  = bool  (*)(const transformed_vertex_t& v, const guard_band_t& band) noexcept;
+        using limit_t = float (*)(const transformed_vertex_t& v, const guard_band_t& band) noexcept;
+
+        test_t  test;
+        limit_t value;
+        limit_t limit;
+    };
+
+    static constexpr clip_rule_t clip_rules[]
+    {
+        { [](const auto& v, const auto& g) noexcept { return  v.p.x <= g.x * v.p.w; }, [](const auto& v, const auto&) noexcept { return v.p.x; }, [](const auto& v, const auto& g) noexcept { return                              g.x * v.p.w; } },
+        { [](const auto& v, const auto& g) noexcept { return  v.p.y <= g.y * v.p.w; }, [](const auto& v, const auto&) noexcept { return v.p.y; }, [](const auto& v, const auto& g) noexcept { return                              g.y * v.p.w; } },
+        { [](const auto& v, const auto&  ) noexcept { return  v.p.z <=       v.p.w; }, [](const auto& v, const auto&) noexcept { return v.p.z; }, [](const auto& v, const auto&  ) noexcept { return                                    v.p.w; } },
+        { [](const auto& v, const auto& g) noexcept { return -g.x * v.p.w  < v.p.x; }, [](const auto& v, const auto&) noexcept { return v.p.x; }, [](const auto& v, const auto& g) noexcept { return -g.x * v.p.w + FLT_EPSILON * 2.0f; } },
+        { [](const auto& v, const auto& g) noexcept { return -g.y * v.p.w  < v.p.y; }, [](const auto& v, const auto&) noexcept { return v.p.y; }, [](const auto& v, const auto& g) noexcept { return -g.y * v.p.w + FLT_EPSILON * 2.0f; } },
+        { [](const auto& v, const auto&  ) noexcept { return          0.0f < v.p.z; }, [](const auto& v, const auto&) noexcept { return v.p.z; }, [](const auto&  , const auto&  ) noexcept { return                       FLT_EPSILON * 2.0f; } },
+    };
+
+    clip_polygon_t  scratch;
+    clip_polygon_t* input  = &result;
+    clip_polygon_t* output = &scratch;
+
+    input->vertices[0]  = triangle.a;
+    input->vertices[1]  = triangle.b;
+    input->vertices[2]  = triangle.c;
+    input->vertex_count = 3;
+
+    for (int plane = 0; plane < 6 && input->vertex_count > 0; ++plane)
+    {
+        if (!(planes & (1 << plane)))
+            continue;
+
+        const auto& rule = clip_rules[plane];
+
+        output->vertex_count = 0;
+
+        for (int i = 0; i < input->vertex_count; ++i)
+        {
+            const auto& a = input->vertices[i];
+            const auto& b = input->vertices[(i + 1) % input->vertex_count];
+
+            const auto a_inside = rule.test(a, band);
+            const auto b_inside = rule.test(b, band);
+
+            if (a_inside)
+                output->vertices[output->vertex_count++] = a;
+
+            if (a_inside != b_inside)
+            {
+                const auto a_value = rule.value(a, band), a_limit = rule.limit(a, band);
+                const auto b_value = rule.value(b, band), b_limit = rule.limit(b, band);
+
+                const auto t = (a_limit - a_value) / (a_limit - b_limit - a_value + b_value);
+
+                output->vertices[output->vertex_count++] = lerp(a, b, t);
+            }
+        }
+
+        std::swap(input, output);
+    }
+
+    if (input != &result)
+        result = *input;
+}
+
+// Homogeneous backface test on clip-space x, y, w, works before clipping and
+// divide. Viewport flips y, so positive determinant is clockwise on screen.
+static bool is_culled(const vec4& a, const vec4& b, const vec4& c, cull_mode_t mode)
+{
+    if (mode == cull_mode_t::none)
+        return false;
+
+    const auto det =
+        a.x * (b.y * c.w - b.w * c.y) -
+        a.y * (b.x * c.w - b.w * c.x) +
+        a.w * (b.x * c.y - b.y * c.x);
+
+    return mode == cull_mode_t::back ? det > 0.0f : det < 0.0f;
+}
+
+static screen_vertex_t project_vertex(const transformed_vertex_t& v, const matrix4& viewport_scale, const guard_band_t& band, const vec3& light)
+{
+    const auto p = v.p.transformed(viewport_scale);
+
+    screen_vertex_t result;
+    result.iw      = 1.0f / p.w;
+    result.p       = vec3(p.x * result.iw, p.y * result.iw, p.z * result.iw);
+    result.c       = std::max(v.n.dot(light) * 0.5f + 0.5f, 0.0f);
+    result.outcode = clip_outcode(v.p, band);
+    return result;
+}
+
+scene_t::scene_t():
+    torus  { make_torus(10, 5, 24, 16), matrix4::identity, cull_mode_t::back },
+    box    { make_box(15, 15, 15),      matrix4::identity, cull_mode_t::back },
+    teapot { make_teapot(5, 4),         matrix4::identity, cull_mode_t::back },
+    line   { make_line(-19.0f, 0.0f, 0.0f, 19.0f, 0.0f, 0.0f), matrix4::identity, cull_mode_t::none },
+    normal { make_normals(teapot.mesh, 0.350f), matrix4::identity, cull_mode_t::none }
+{
+}
+
+void scene_t::animate(float time, const scene_options_t& options)
+{
+    const auto scale = options.scale;
+    const auto angle = options.angle;
+
+    torus.transformation =
+        matrix4::scale(scale, scale, scale) *
+        //matrix4::rotationYawPitchRoll(time - 1, time * 0.1f, 0) *
+        matrix4::rotationYawPitchRoll(time, time * 0.4f, time * -0.25f) *
+        matrix4::identity;
+    torus.transformation[12] = -20;// * sinf(time * 1.25f);
+    torus.transformation = torus.transformation *
+        matrix4::rotationYawPitchRoll(0.0f, 0.0f, angle);
+
+    box.transformation =
+        matrix4::scale(scale, scale, scale) *
+        matrix4::rotationYawPitchRoll(time + 1, -time * 0.2f, time * -0.35f) *
+        matrix4::identity;
+    box.transformation[12]   =  20;// * sinf(time * 1.25f);
+    box.transformation = box.transformation *
+        matrix4::rotationYawPitchRoll(0.0f, 0.0f, angle);
+
+    teapot.transformation =
+        matrix4::scale(scale, scale, scale) *
+        matrix4::translation(0, 0, -4) *
+        matrix4::rotationYawPitchRoll(time - 1, time * 0.1f, time * 0.45f) *
+        matrix4::translation(0, 0, 0) *
+        matrix4::rotationYawPitchRoll(0.0f, 0.0f, angle);
+
+    //teapot.transformation =
+    //    matrix4::scale(scale, scale, scale) *
+    //    matrix4::translation(0, 0, -6) *
+    //    matrix4::rotationYawPitchRoll(time - 1, time * 0.1f, time * 0.45f) *
+    //    matrix4::rotationYawPitchRoll(0, 0, angle + time * 0.45f) *
+    //    //matrix4::rotationYawPitchRoll(0.0f, 0.0f, angle + time * 0.45f) *
+    //    matrix4::translation(0, -16, 0);
+
+    line.transformation =
+        //matrix4::translation(0, 0, 0) *
+        //matrix4::rotationYawPitchRoll(time - 1, time * 0.1f, time * 0.45f) *
+        //matrix4::rotationYawPitchRoll(0.0f, 0.0f, time * 0.45f) *
+        //matrix4::translation(0, 0, 0) *
+        torus.transformation;
+
+    normal.transformation =
+        //matrix4::translation(0, 0, 0) *
+        //matrix4::rotationYawPitchRoll(time - 1, time * 0.1f, time * 0.45f) *
+        //matrix4::rotationYawPitchRoll(0.0f, 0.0f, time * 0.45f) *
+        //matrix4::translation(0, 0, 0) *
+        teapot.transformation;
+}
+
+void scene_t::draw(framebuffer_t& buffer, tile_rasterizer_t& rasterizer, float aspect, const scene_options_t& options)
+{
+    const auto solid        = options.solid;
+    const auto lines        = options.lines;
+    const auto wireframe    = options.wireframe;
+    const auto wireframe_2d = options.wireframe_2d;
+
+    scene_object_t* objects[] =
+    {
+        &torus,
+        &box,
+        &teapot,
+        &line,
+        &normal,
+    };
+
+    const viewport_t viewport =
+    {
+        0.0f,//buffer.width,
+        -buffer.height / 2.0f,
+        (float)buffer.width / 2,
+        (float)buffer.height / 2,
+        0.0f,
+        1.0f,
+    };
+
+    const auto view       = matrix4::lookAtLH(vec3(0, -50, 0), vec3(0, 0, 0), vec3(0, 0, 1));
+    const auto projection = matrix4::perspectiveFovLH((float)M_PI / 8.0f, aspect, 1.0f, 500.0f);
+
+    const auto camera_transformation = view * projection;
+
+    const auto clip_transformation = matrix4::clip(
+        viewport.clipX, viewport.clipY, viewport.clipWidth, viewport.clipHeight, viewport.minZ, viewport.maxZ);
+
+    const auto viewport_scale =
+        matrix4::translation(1.0f, -1.0f, 0.0f) *
+        matrix4::scale(0.5f * buffer.width, -0.5f * buffer.height, 1.0f)
+        ;
+
+    const auto light = vec3(5, 0, 10).normalized();
+
+    // Widest guard band rasterizer still handles exactly, see triangle_3d_max_extent
+    const guard_band_t guard_band =
+    {
+        std::max(1.0f, static_cast<float>(triangle_3d_max_extent) / buffer.width),
+        std::max(1.0f, static_cast<float>(triangle_3d_max_extent) / buffer.height),
+    };
+
+    for (int i = 0; i < (int)std::size(objects); ++i)
+    {
+        auto& object = *objects[i];
+
+        const auto& indices  = object.mesh.indices;
+        vertices.reserve(object.mesh.vertices.size());
+        vertices.resize(0);
+
+        const auto transformation = object.transformation * camera_transformation * clip_transformation;
+        const auto transposed     = (object.transformation * view).transposed();
+
+        for (auto& vertex : object.mesh.vertices)
+        {
+            transformed_vertex_t v;
+            v.p = vec4(vertex.p, 1.0f).transformed(transformation);
+            v.n = vertex.n.transformed_vector(object.transformation).normalized();
+            v.c = vertex.c;
+
+            vertices.push_back(v);
+        }
+
+        screen_vertices.resize(vertices.size());
+        for (size_t j = 0; j < vertices.size(); ++j)
+            screen_vertices[j] = project_vertex(vertices[j], viewport_scale, guard_band, light);
+
+        float minZ = 1.0f;
+        float maxZ = 0.0f;
+# if 0
+        for (auto& vtx : vertices)
+        {
+            minZ = std::min(minZ, vtx.p.z);
+            maxZ = std::max(maxZ, vtx.p.z);
+
+            //buffer.set(vtx.p.x, vtx.p.y, 1.0f);
+        }
+# else
+        minZ = 0.96f;
+        maxZ = 0.99f;
+# endif
+
+        if (solid && object.mesh.primitive_type == primitive_type_t::triangle_list)
+        {
+            const auto draw_triangle = [&rasterizer](const screen_vertex_t& v0, const screen_vertex_t& v1, const screen_vertex_t& v2)
+            {
+                const auto& o0 = v0.p;
+                const auto& o1 = v1.p;
+                const auto& o2 = v2.p;
+
+                rasterizer.triangle(
+                    o1.x, o1.y, o1.z,
+                    o0.x, o0.y, o0.z,
+                    o2.x, o2.y, o2.z,
+                    v1.c, v0.c, v2.c);
+            };
+
+            for (int i = 0; i < (int)indices.size() / 3; ++i)
+            {
+                auto i0 = indices[i * 3 + 0], i1 = indices[i * 3 + 1], i2 = indices[i * 3 + 2];
+
+                const auto& s0 = screen_vertices[i0];
+                const auto& s1 = screen_vertices[i1];
+                const auto& s2 = screen_vertices[i2];
+
+                // Trivial reject, all vertices are outside of the same plane
+                if (s0.outcode & s1.outcode & s2.outcode)
+                    continue;
+
+                if (is_culled(vertices[i0].p, vertices[i1].p, vertices[i2].p, object.cull_mode))
+                    continue;
+
+                // Trivial accept, all vertices are inside of guard band
+                const auto planes = (s0.outcode | s1.outcode | s2.outcode) & clip_plane_all;
+                if (!planes)
+                {
+                    draw_triangle(s0, s1, s2);
+                    continue;
+                }
+
+                const transformed_triangle_t triangle = { vertices[i0], vertices[i1], vertices[i2] };
+                clip_polygon_t polygon;
+                clip_triangle(triangle, planes, guard_band, polygon);
+
+                screen_vertex_t projected[3 + 6];
+                for (int j = 0; j < polygon.vertex_count; ++j)
+                    projected[j] = project_vertex(polygon.vertices[j], viewport_scale, guard_band, light);
+
+                for (int j = 2; j < polygon.vertex_count; ++j)
+                    draw_triangle(projected[0], projected[j - 1], projected[j]);
+            }
+        }
+
+        if (object.mesh.primitive_type == primitive_type_t::triangle_list && (wireframe || wireframe_2d))
+        {
+            rasterizer.flush();
+
+            for (int i = 0; i < (int)indices.size() / 3; ++i)
+            {
+                auto i0 = indices[i * 3 + 0], i1 = indices[i * 3 + 1], i2 = indices[i * 3 + 2];
+
+                const auto& v0 = screen_vertices[i0];
+                const auto& v1 = screen_vertices[i1];
+                const auto& v2 = screen_vertices[i2];
+
+                if (is_culled(vertices[i0].p, vertices[i1].p, vertices[i2].p, object.cull_mode))
+                    continue;
+
+                const auto& o0 = v0.p;
+                const auto& o1 = v1.p;
+                const auto& o2 = v2.p;
+
+                const auto c0 = v0.c;
+                const auto c1 = v1.c;
+                const auto c2 = v2.c;
+
+                if (wireframe)
+                {
+                    generic_line_3d(buffer,
+                        o1.x, o1.y, o1.z,
+                        o0.x, o0.y, o0.z,
+                        c1, c0);
+
+                    generic_line_3d(buffer,
+                        o1.x, o1.y, o1.z,
+                        o2.x, o2.y, o2.z,
+                        c1, c2);
+
+                    generic_line_3d(buffer,
+                        o0.x, o0.y, o0.z,
+                        o2.x, o2.y, o2.z,
+                        c0, c2);
+                }
+
+                if (wireframe_2d)
+                {
+                    generic_line_2d(buffer,
+                        static_cast<int>(o1.x), static_cast<int>(o1.y),
+                        static_cast<int>(o0.x), static_cast<int>(o0.y),
+                        (c1 + c0) * 0.5f);
+
+                    generic_line_2d(buffer,
+                        static_cast<int>(o1.x), static_cast<int>(o1.y),
+                        static_cast<int>(o2.x), static_cast<int>(o2.y),
+                        (c1 + c2) * 0.5f);
+
+                    generic_line_2d(buffer,
+                        static_cast<int>(o0.x), static_cast<int>(o0.y),
+                        static_cast<int>(o2.x), static_cast<int>(o2.y),
+                        (c0 + c2) * 0.5f);
+                }
+            }
+        }
+
+        if (object.mesh.primitive_type == primitive_type_t::line_list && (lines || wireframe || wireframe_2d))
+        {
+            rasterizer.flush();
+
+            auto invertedTransformation = (object.transformation * camera_transformation).inverted();
+
+            for (int i = 0; i < (int)indices.size() / 2; ++i)
+            {
+                auto i0 = indices[i * 2 + 0], i1 = indices[i * 2 + 1];
+
+                const auto& o0 = screen_vertices[i0].p;
+                const auto& o1 = screen_vertices[i1].p;
+
+                const auto c0 = 1.0f;// - (v0.p.z - minZ) / (maxZ - minZ);
+                const auto c1 = 1.0f;// - (v1.p.z - minZ) / (maxZ - minZ);
+
+                if (lines || wireframe)
+                {
+                    generic_line_3d(buffer,
+                        o1.x, o1.y, o1.z,
+                        o0.x, o0.y, o0.z,
+                        c1, c0);
+                }
+
+                if (wireframe_2d)
+                {
+                    generic_line_2d(buffer,
+                        static_cast<int>(o1.x), static_cast<int>(o1.y),
+                        static_cast<int>(o0.x), static_cast<int>(o0.y),
+                        (c1 + c0) * 0.5f);
+                }
+            }
+        }
+    }
+
+    rasterizer.flush();
+}
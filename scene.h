@@ -0,0 +1,80 @@
+#pragma once
+#include "drawing.h"
+#include "math.h"
+#include "mesh.h"
+#include "tile_rasterizer.h"
+#include <vector>
+
+enum class cull_mode_t
+{
+    none,
+    back,
+    front
+};
+
+struct scene_object_t
+{
+    mesh_t      mesh;
+    matrix4     transformation;
+    cull_mode_t cull_mode;
+};
+
+struct scene_options_t
+{
+    bool  solid        = true;
+    bool  lines        = true;
+    bool  wireframe    = false;
+    bool  wireframe_2d = false;
+    float angle        = 0.0f;
+    float scale        = 1.0f;
+};
+
+struct transformed_vertex_t
+{
+    vec4  p{};
+    vec3  n{};
+    float c{};
+
+    friend transformed_vertex_t lerp(const transformed_vertex_t& a, const transformed_vertex_t& b, float t)
+    {
+        return
+        {
+            a.p + t * (b.p - a.p),
+            a.n + t * (b.n - a.n),
+            a.c + t * (b.c - a.c),
+        };
+    }
+};
+
+// Vertex after viewport transform and perspective divide, shared by all passes.
+struct screen_vertex_t
+{
+    vec3  p{};
+    float iw{};             // 1 / w
+    float c{};              // lit intensity
+    int   outcode{};        // planes vertex is outside of, see clip_plane_t
+};
+
+// Demo scene, spinning torus, box and teapot with its normals. Shared by
+// windowed and offscreen front ends, so both render the same frames.
+struct scene_t
+{
+    scene_object_t torus;
+    scene_object_t box;
+    scene_object_t teapot;
+    scene_object_t line;
+    scene_object_t normal;
+
+    scene_t();
+
+    // Places objects for given time in seconds.
+    void animate(float time, const scene_options_t& options);
+
+    // Draws scene to 'buffer'. Rasterizer has to be begun with the same buffer,
+    // draw() flushes it. 'aspect' is aspect ratio of the projection.
+    void draw(framebuffer_t& buffer, tile_rasterizer_t& rasterizer, float aspect, const scene_options_t& options);
+
+private:
+    std::vector<transformed_vertex_t> vertices;
+    std::vector<screen_vertex_t>      screen_vertices;
+};
@@ -0,0 +1,286 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#if !defined(ASCII_RENDER_NO_SIMD)
+#   if defined(__AVX2__)
+#       define ASCII_RENDER_AVX2
+#   endif
+#   if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#       define ASCII_RENDER_SSE2
+#   endif
+#endif
+
+#if defined(ASCII_RENDER_AVX2)
+#   include <immintrin.h>
+#elif defined(ASCII_RENDER_SSE2)
+#   include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+// Lane packs used by row kernels in drawing.inl. Every pack performs the same
+// IEEE single precision operations in the same order (multiply and add are kept
+// separate), so kernels give bit-identical results for every lane count.
+// Comparisons return lane bitmasks, bit N set for lane N. Integer lanes are
+// stored to bytes only when they are in 0 .. 255.
+
+struct scalar_lanes_t
+{
+    static constexpr int count = 1;
+
+    struct f32
+    {
+        float v;
+
+        friend f32 operator + (f32 a, f32 b) { return { a.v + b.v }; }
+        friend f32 operator - (f32 a, f32 b) { return { a.v - b.v }; }
+        friend f32 operator * (f32 a, f32 b) { return { a.v * b.v }; }
+        friend f32 operator / (f32 a, f32 b) { return { a.v / b.v }; }
+    };
+
+    struct i32
+    {
+        int32_t v;
+
+        friend i32 operator + (i32 a, i32 b) { return { a.v + b.v }; }
+    };
+
+    static f32 splat(float v)               { return { v }; }
+    static i32 splat(int32_t v)             { return { v }; }
+    static i32 ramp(int32_t base, int32_t)  { return { base }; }
+
+    static f32 to_float(i32 v)              { return { static_cast<float>(v.v) }; }
+    static i32 to_int(f32 v)                { return { static_cast<int32_t>(v.v) }; }
+
+    static f32 min(f32 a, f32 b)            { return { b.v < a.v ? b.v : a.v }; }
+    static f32 max(f32 a, f32 b)            { return { a.v < b.v ? b.v : a.v }; }
+
+    static unsigned positive(i32 v)         { return v.v > 0; }
+    static unsigned greater(f32 a, f32 b)   { return a.v > b.v; }
+    static unsigned greater_equal(f32 a, f32 b) { return a.v >= b.v; }
+    static unsigned less_equal(f32 a, f32 b)    { return a.v <= b.v; }
+
+    static f32 select(unsigned mask, f32 a, f32 b) { return mask ? a : b; }
+
+    static f32  load(const float* p)        { return { *p }; }
+    static void store(float* p, f32 v)      { *p = v.v; }
+    static void store(int32_t* p, i32 v)    { *p = v.v; }
+    static void store(uint8_t* p, i32 v)    { *p = static_cast<uint8_t>(v.v); }
+};
+
+#if defined(ASCII_RENDER_SSE2)
+struct sse2_lanes_t
+{
+    static constexpr int count = 4;
+
+    struct f32
+    {
+        __m128 v;
+
+        friend f32 operator + (f32 a, f32 b) { return { _mm_add_ps(a.v, b.v) }; }
+        friend f32 operator - (f32 a, f32 b) { return { _mm_sub_ps(a.v, b.v) }; }
+        friend f32 operator * (f32 a, f32 b) { return { _mm_mul_ps(a.v, b.v) }; }
+        friend f32 operator / (f32 a, f32 b) { return { _mm_div_ps(a.v, b.v) }; }
+    };
+
+    struct i32
+    {
+        __m128i v;
+
+        friend i32 operator + (i32 a, i32 b) { return { _mm_add_epi32(a.v, b.v) }; }
+    };
+
+    static f32 splat(float v)               { return { _mm_set1_ps(v) }; }
+    static i32 splat(int32_t v)             { return { _mm_set1_epi32(v) }; }
+    static i32 ramp(int32_t base, int32_t step)
+    {
+        return { _mm_setr_epi32(base, base + step, base + 2 * step, base + 3 * step) };
+    }
+
+    static f32 to_float(i32 v)              { return { _mm_cvtepi32_ps(v.v) }; }
+    static i32 to_int(f32 v)                { return { _mm_cvttps_epi32(v.v) }; }
+
+    static f32 min(f32 a, f32 b)            { return { _mm_min_ps(b.v, a.v) }; }
+    static f32 max(f32 a, f32 b)            { return { _mm_max_ps(b.v, a.v) }; }
+
+    static unsigned positive(i32 v)         { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v.v, _mm_setzero_si128()))); }
+    static unsigned greater(f32 a, f32 b)   { return _mm_movemask_ps(_mm_cmpgt_ps(a.v, b.v)); }
+    static unsigned greater_equal(f32 a, f32 b) { return _mm_movemask_ps(_mm_cmpge_ps(a.v, b.v)); }
+    static unsigned less_equal(f32 a, f32 b)    { return _mm_movemask_ps(_mm_cmple_ps(a.v, b.v)); }
+
+    static f32 select(unsigned mask, f32 a, f32 b)
+    {
+        const auto bits = _mm_setr_epi32(1, 2, 4, 8);
+        const auto m    = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(static_cast<int>(mask)), bits), bits));
+        return { _mm_or_ps(_mm_and_ps(m, a.v), _mm_andnot_ps(m, b.v)) };
+    }
+
+    static f32  load(const float* p)        { return { _mm_loadu_ps(p) }; }
+    static void store(float* p, f32 v)      { _mm_storeu_ps(p, v.v); }
+    static void store(int32_t* p, i32 v)    { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v.v); }
+
+    static void store(uint8_t* p, i32 v)
+    {
+        const auto bytes = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(v.v, v.v), _mm_setzero_si128()));
+        std::memcpy(p, &bytes, 4);
+    }
+};
+#endif
+
+#if defined(ASCII_RENDER_AVX2)
+struct avx2_lanes_t
+{
+    static constexpr int count = 8;
+
+    struct f32
+    {
+        __m256 v;
+
+        friend f32 operator + (f32 a, f32 b) { return { _mm256_add_ps(a.v, b.v) }; }
+        friend f32 operator - (f32 a, f32 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+        friend f32 operator * (f32 a, f32 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+        friend f32 operator / (f32 a, f32 b) { return { _mm256_div_ps(a.v, b.v) }; }
+    };
+
+    struct i32
+    {
+        __m256i v;
+
+        friend i32 operator + (i32 a, i32 b) { return { _mm256_add_epi32(a.v, b.v) }; }
+    };
+
+    static f32 splat(float v)               { return { _mm256_set1_ps(v) }; }
+    static i32 splat(int32_t v)             { return { _mm256_set1_epi32(v) }; }
+    static i32 ramp(int32_t base, int32_t step)
+    {
+        return { _mm256_add_epi32(_mm256_set1_epi32(base), _mm256_mullo_epi32(_mm256_set1_epi32(step), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))) };
+    }
+
+    static f32 to_float(i32 v)              { return { _mm256_cvtepi32_ps(v.v) }; }
+    static i32 to_int(f32 v)                { return { _mm256_cvttps_epi32(v.v) }; }
+
+    static f32 min(f32 a, f32 b)            { return { _mm256_min_ps(b.v, a.v) }; }
+    static f32 max(f32 a, f32 b)            { return { _mm256_max_ps(b.v, a.v) }; }
+
+    static unsigned positive(i32 v)         { return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v.v, _mm256_setzero_si256()))); }
+    static unsigned greater(f32 a, f32 b)   { return _mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)); }
+    static unsigned greater_equal(f32 a, f32 b) { return _mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)); }
+    static unsigned less_equal(f32 a, f32 b)    { return _mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)); }
+
+    static f32 select(unsigned mask, f32 a, f32 b)
+    {
+        const auto bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const auto m    = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(mask)), bits), bits));
+        return { _mm256_blendv_ps(b.v, a.v, m) };
+    }
+
+    static f32  load(const float* p)        { return { _mm256_loadu_ps(p) }; }
+    static void store(float* p, f32 v)      { _mm256_storeu_ps(p, v.v); }
+    static void store(int32_t* p, i32 v)    { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v.v); }
+
+    static void store(uint8_t* p, i32 v)
+    {
+        const auto words = _mm_packs_epi32(_mm256_castsi256_si128(v.v), _mm256_extracti128_si256(v.v, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(words, words));
+    }
+};
+#endif
+
+#if defined(ASCII_RENDER_AVX2)
+typedef avx2_lanes_t simd_lanes_t;
+#elif defined(ASCII_RENDER_SSE2)
+typedef sse2_lanes_t simd_lanes_t;
+#else
+typedef scalar_lanes_t simd_lanes_t;
+#endif
+
+// Index of lowest/highest set bit, mask has to be non-zero.
+inline int lowest_bit(unsigned mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+inline int highest_bit(unsigned mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return static_cast<int>(index);
+#else
+    return 31 - __builtin_clz(mask);
+#endif
+}
+
+// Fills 'count' values with non-temporal stores, so large fills do not evict
+// cache for data nobody reads soon. Values are 1, 2 or 4 bytes large.
+template <typename T>
+inline void stream_fill(T* data, size_t count, const T& value)
+{
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4, "stream_fill handles 8, 16 and 32 bit values");
+
+#if defined(ASCII_RENDER_SSE2)
+    auto end = data + count;
+
+    // Head until 16 byte boundary
+    while (data < end && (reinterpret_cast<uintptr_t>(data) & 15))
+        *data++ = value;
+
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(T));
+    if (sizeof(T) == 1)
+        bits |= bits << 8;
+    if (sizeof(T) <= 2)
+        bits |= bits << 16;
+
+    const auto pattern = _mm_set1_epi32(static_cast<int>(bits));
+    const auto step    = static_cast<ptrdiff_t>(16 / sizeof(T));
+    for (; end - data >= step; data += step)
+        _mm_stream_si128(reinterpret_cast<__m128i*>(data), pattern);
+
+    _mm_sfence();
+
+    while (data < end)
+        *data++ = value;
+#else
+    std::fill_n(data, count, value);
+#endif
+}
+
+// Expands 8-bit intensities to 32-bit gray pixels, intensity in the three low
+// bytes and 0xFF in the top one.
+inline void expand_gray(const uint8_t* src, uint32_t* dst, size_t count)
+{
+    size_t i = 0;
+
+#if defined(ASCII_RENDER_SSE2)
+    const auto alpha = _mm_set1_epi8(-1);
+
+    for (; i + 16 <= count; i += 16)
+    {
+        const auto v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const auto lo = _mm_unpacklo_epi8(v, v);        // v, v
+        const auto la = _mm_unpacklo_epi8(v, alpha);    // v, 0xFF
+        const auto hi = _mm_unpackhi_epi8(v, v);
+        const auto ha = _mm_unpackhi_epi8(v, alpha);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i +  0), _mm_unpacklo_epi16(lo, la));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i +  4), _mm_unpackhi_epi16(lo, la));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i +  8), _mm_unpacklo_epi16(hi, ha));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 12), _mm_unpackhi_epi16(hi, ha));
+    }
+#endif
+
+    for (; i < count; ++i)
+        dst[i] = 0xFF000000u | src[i] * 0x010101u;
+}
@@ -0,0 +1,54 @@
+#include "headless_framebuffer.h"
+#include "ascii_framebuffer.h"
+#include "font.h"
+#include <cmath>
+#include <limits>
+#include <cstdio>
+
+// Colors outside of [0, 1], infinities and NaN included, still turn into cells
+// of the palette: NaN and -inf like the darkest color, +inf like 1.
+int main()
+{
+    const auto inf = std::numeric_limits<float>::infinity();
+    const auto nan = std::numeric_limits<float>::quiet_NaN();
+
+    // 19 cells per row, so rows end with lanes converted one at a time
+    headless_framebuffer_t target(19 * 6, 4 * 8);
+    ascii_framebuffer_t    ascii(target, { get_font_5x7(), " .',\";o%O8@#", 1 });
+
+    const float specials[] = { nan, inf, -inf, -2.0f, 2.0f };
+    const float expected[] = { 1e-6f, 1.0f, 1e-6f, 1e-6f, 1.0f };
+    const int   count = sizeof(specials) / sizeof(*specials);
+
+    // Row 0 holds references, rows 1.. put every special value in every lane
+    for (int x = 0; x < ascii.width; ++x)
+        for (int y = 0; y < ascii.height; ++y)
+            ascii.color[x + y * ascii.width] = y ? specials[(x + y) % count] : expected[x % count];
+
+    ascii.commit();
+
+    if (ascii.cells.size() != static_cast<size_t>(ascii.width * ascii.height))
+    {
+        printf("cells: target did not accept copy_gray8_2d\n");
+        return 1;
+    }
+
+    int failures = 0;
+    for (int y = 1; y < ascii.height; ++y)
+    {
+        for (int x = 0; x < ascii.width; ++x)
+        {
+            const auto i    = (x + y) % count;
+            const auto cell = ascii.cells[x + y * ascii.width];
+            const auto want = ascii.cells[i];   // row 0, x == i has the reference
+
+            if (cell > ascii.palette.size() || cell != want)
+            {
+                printf("cells: %f at %d,%d gives %d, expected %d\n", specials[i], x, y, cell, want);
+                ++failures;
+            }
+        }
+    }
+
+    return failures ? 1 : 0;
+}
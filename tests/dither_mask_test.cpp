@@ -0,0 +1,58 @@
+#include "dither_mask.h"
+#include <cstdio>
+
+// Bayer masks against the well known 4x4 matrix and rank permutation of the
+// other sizes.
+int main()
+{
+    static const uint16_t bayer_4x4[] =
+    {
+         0,  8,  2, 10,
+        12,  4, 14,  6,
+         3, 11,  1,  9,
+        15,  7, 13,  5
+    };
+
+    int failures = 0;
+
+    auto& mask = get_bayer_mask(4);
+    if (mask.size != 4)
+    {
+        printf("bayer 4: size %d\n", mask.size);
+        return 1;
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        if (mask.ranks[i] != bayer_4x4[i])
+        {
+            printf("bayer 4: rank at %d,%d is %d, expected %d\n", i % 4, i / 4, mask.ranks[i], bayer_4x4[i]);
+            ++failures;
+        }
+    }
+
+    for (int size = 2; size <= 16; size *= 2)
+    {
+        auto& m = get_bayer_mask(size);
+
+        bool seen[16 * 16] = {};
+        for (int i = 0; i < size * size; ++i)
+        {
+            if (m.ranks[i] >= size * size || seen[m.ranks[i]])
+            {
+                printf("bayer %d: rank %d at %d,%d repeated or out of range\n", size, m.ranks[i], i % size, i / size);
+                ++failures;
+            }
+            else
+                seen[m.ranks[i]] = true;
+        }
+    }
+
+    if (get_bayer_mask(3).size != 4 || get_bayer_mask(64).size != 16)
+    {
+        printf("bayer: sizes do not round up to the next one\n");
+        ++failures;
+    }
+
+    return failures ? 1 : 0;
+}
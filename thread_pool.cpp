@@ -0,0 +1,85 @@
+#include "thread_pool.h"
+
+thread_pool_t::thread_pool_t(int thread_count)
+{
+    if (thread_count <= 0)
+        thread_count = static_cast<int>(std::thread::hardware_concurrency());
+
+    for (int i = 1; i < thread_count; ++i)
+        workers.emplace_back([this] { worker_main(); });
+}
+
+thread_pool_t::~thread_pool_t()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void thread_pool_t::parallel_for(int count, const std::function<void(int index)>& job)
+{
+    if (count <= 0)
+        return;
+
+    if (workers.empty() || count == 1)
+    {
+        for (int i = 0; i < count; ++i)
+            job(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->job  = &job;
+        job_count  = count;
+        next_index = 0;
+        busy       = static_cast<int>(workers.size());
+        ++generation;
+    }
+    wake.notify_all();
+
+    run_jobs();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+    this->job = nullptr;
+}
+
+void thread_pool_t::worker_main()
+{
+    unsigned seen_generation = 0;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        wake.wait(lock, [&] { return quit || generation != seen_generation; });
+        if (quit)
+            return;
+
+        seen_generation = generation;
+
+        lock.unlock();
+        run_jobs();
+        lock.lock();
+
+        if (--busy == 0)
+            done.notify_one();
+    }
+}
+
+void thread_pool_t::run_jobs()
+{
+    for (int index = next_index++; index < job_count; index = next_index++)
+        (*job)(index);
+}
+
+thread_pool_t& get_thread_pool()
+{
+    static thread_pool_t pool;
+    return pool;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads executing indexed jobs. Calling thread takes part
+// in the work, so pool of N threads runs N - 1 workers. Not reentrant.
+struct thread_pool_t
+{
+    explicit thread_pool_t(int thread_count = 0);
+    ~thread_pool_t();
+
+    thread_pool_t(const thread_pool_t&) = delete;
+    thread_pool_t& operator=(const thread_pool_t&) = delete;
+
+    int thread_count() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Runs job(index) for every index in [0, count) and waits for all of them to finish.
+    // Jobs start in order of index, job may wait for one with lower index.
+    void parallel_for(int count, const std::function<void(int index)>& job);
+
+private:
+    void worker_main();
+    void run_jobs();
+
+    std::vector<std::thread>         workers;
+    std::mutex                       mutex;
+    std::condition_variable          wake;
+    std::condition_variable          done;
+    const std::function<void(int)>*  job        = nullptr;
+    int                              job_count  = 0;
+    std::atomic<int>                 next_index { 0 };
+    int                              busy       = 0;
+    unsigned                         generation = 0;
+    bool                             quit       = false;
+};
+
+thread_pool_t& get_thread_pool();
@@ -0,0 +1,90 @@
+#include "tile_rasterizer.h"
+#include "thread_pool.h"
+#include <algorithm>
+
+using std::min;
+using std::max;
+template <typename T> static inline T min(T a, T b, T c) { return std::min(a, std::min(b, c)); }
+template <typename T> static inline T max(T a, T b, T c) { return std::max(a, std::max(b, c)); }
+
+static_assert(tile_rasterizer_t::tile_size % framebuffer_t::depth_tile_size == 0, "tiles must not share depth tiles");
+
+void tile_rasterizer_t::begin(framebuffer_t& buffer, rasterize_proc rasterize)
+{
+    flush();
+
+    this->buffer    = &buffer;
+    this->rasterize = rasterize;
+
+    tiles_x = (buffer.width  + tile_size - 1) / tile_size;
+    tiles_y = (buffer.height + tile_size - 1) / tile_size;
+
+    bins.resize(tiles_x * tiles_y);
+}
+
+void tile_rasterizer_t::triangle(
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2,
+    float c0, float c1, float c2)
+{
+    // Same bounding rectangle as generic_triangle_3d (28.4 fixed-point)
+    const int X0 = (int)(x0 * 16.0f), Y0 = (int)(y0 * 16.0f);
+    const int X1 = (int)(x1 * 16.0f), Y1 = (int)(y1 * 16.0f);
+    const int X2 = (int)(x2 * 16.0f), Y2 = (int)(y2 * 16.0f);
+
+    const int minx = max((min(X0, X1, X2) + 0x0F) >> 4, 0);
+    const int maxx = min((max(X0, X1, X2) + 0x0F) >> 4, buffer->width);
+    const int miny = max((min(Y0, Y1, Y2) + 0x0F) >> 4, 0);
+    const int maxy = min((max(Y0, Y1, Y2) + 0x0F) >> 4, buffer->height);
+
+    if (minx >= maxx || miny >= maxy)
+        return;
+
+    const auto index = static_cast<uint32_t>(triangles.size());
+    triangles.push_back({ x0, y0, z0, x1, y1, z1, x2, y2, z2, c0, c1, c2 });
+
+    for (int ty = miny / tile_size; ty <= (maxy - 1) / tile_size; ++ty)
+    {
+        for (int tx = minx / tile_size; tx <= (maxx - 1) / tile_size; ++tx)
+        {
+            const auto bin_index = tx + ty * tiles_x;
+            auto& bin = bins[bin_index];
+
+            if (bin.empty())
+                active_bins.push_back(bin_index);
+
+            bin.push_back(index);
+        }
+    }
+}
+
+void tile_rasterizer_t::flush()
+{
+    if (active_bins.empty())
+        return;
+
+    get_thread_pool().parallel_for(static_cast<int>(active_bins.size()), [this](int index)
+    {
+        const auto bin_index = active_bins[index];
+        const auto tx        = bin_index % tiles_x;
+        const auto ty        = bin_index / tiles_x;
+
+        const rect_t scissor =
+        {
+            tx * tile_size,
+            ty * tile_size,
+            min((tx + 1) * tile_size, buffer->width),
+            min((ty + 1) * tile_size, buffer->height)
+        };
+
+        for (auto triangle_index : bins[bin_index])
+            rasterize(*buffer, scissor, triangles[triangle_index]);
+    });
+
+    for (auto bin_index : active_bins)
+        bins[bin_index].clear();
+
+    active_bins.clear();
+    triangles.clear();
+}
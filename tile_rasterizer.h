@@ -0,0 +1,55 @@
+#pragma once
+#include "drawing.h"
+#include <vector>
+#include <cstdint>
+
+// Defers generic_triangle_3d calls, sorts them into screen tiles and rasterizes
+// tiles in parallel. Triangles within a tile keep submission order, so output is
+// identical to drawing them one by one.
+struct tile_rasterizer_t
+{
+    static constexpr int tile_size = 64;
+
+    // Rasterizer is instantiated for type of the buffer.
+    template <typename target_t>
+    void begin(target_t& buffer)
+    {
+        begin(buffer, [](framebuffer_t& buffer, const rect_t& scissor, const triangle_t& t)
+        {
+            generic_triangle_3d(static_cast<target_t&>(buffer), scissor,
+                t.x0, t.y0, t.z0,
+                t.x1, t.y1, t.z1,
+                t.x2, t.y2, t.z2,
+                t.c0, t.c1, t.c2);
+        });
+    }
+
+    void triangle(
+        float x0, float y0, float z0,
+        float x1, float y1, float z1,
+        float x2, float y2, float z2,
+        float c0, float c1, float c2);
+
+    void flush();
+
+private:
+    struct triangle_t
+    {
+        float x0, y0, z0;
+        float x1, y1, z1;
+        float x2, y2, z2;
+        float c0, c1, c2;
+    };
+
+    typedef void (*rasterize_proc)(framebuffer_t& buffer, const rect_t& scissor, const triangle_t& triangle);
+
+    void begin(framebuffer_t& buffer, rasterize_proc rasterize);
+
+    framebuffer_t*                      buffer    = nullptr;
+    rasterize_proc                      rasterize = nullptr;
+    int                                 tiles_x = 0;
+    int                                 tiles_y = 0;
+    std::vector<triangle_t>             triangles;
+    std::vector<std::vector<uint32_t>>  bins;
+    std::vector<int>                    active_bins;
+};
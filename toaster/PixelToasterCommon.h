@@ -174,6 +174,13 @@ namespace PixelToaster
 			return true;
 		}
 
+		// zoom window by integer factor.
+		// override this to implement your own zoom, null display ignores it.
+
+		virtual void zoom( int factor )
+		{
+		}
+
 	private:
 
 		char _title[256];
@@ -0,0 +1,59 @@
+#include "toaster_framebuffer.h"
+#include <cstring>
+
+void toaster_framebuffer_t::copy_stale(const pixel_t* presented)
+{
+    auto& rect = stale[colors_slot];
+
+    for (int y = rect.y0; y < rect.y1; ++y)
+    {
+        const auto offset = rect.x0 + static_cast<size_t>(y) * width;
+        std::memcpy(colors + offset, presented + offset, rect.x1 - rect.x0);
+    }
+
+    rect = {};
+}
+
+void toaster_framebuffer_t::present_main(const char* title, int zoom, PixelToaster::Listener* listener)
+{
+    display.open(title, width, height);
+    display.listener(listener);
+    display.zoom(zoom);
+
+    display_state = display.open() ? 1 : 2;
+    display_state.notify_all();
+
+    PixelToaster::Output presented_output;
+
+    int    slot;
+    rect_t dirty;
+    while (display.open() && queue.take(slot, dirty))
+    {
+        // Switching output recreates display surface, it needs whole frame again
+        const auto full = display.output() != presented_output;
+        presented_output = display.output();
+
+        // Only changed part is converted and copied. Update has to happen even
+        // if nothing changed, it also pumps window messages.
+        if (full)
+            dirty = { 0, 0, width, height };
+        else if (dirty.x0 >= dirty.x1)
+            dirty = { 0, 0, 1, 1 };
+
+        const auto pixels = buffers[slot].data();
+        for (int y = dirty.y0; y < dirty.y1; ++y)
+        {
+            const auto offset = dirty.x0 + y * width;
+            expand_gray(pixels + offset, reinterpret_cast<uint32_t*>(converted.data() + offset), dirty.x1 - dirty.x0);
+        }
+
+        queue.release(slot);
+
+        const PixelToaster::Rectangle box(dirty.x0, dirty.x1, dirty.y0, dirty.y1);
+        display.update(converted, full ? nullptr : &box);
+    }
+
+    display_state = 2;
+    queue.close();
+    display.close();
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "toaster/PixelToaster.h"
+#include "gray8_framebuffer.h"
+#include "present_queue.h"
+#include "frame_sink.h"
+#include <vector>
+#include <atomic>
+#include <thread>
+
+struct toaster_framebuffer_t final: gray8_framebuffer_t<toaster_framebuffer_t>
+{
+    friend concrete_framebuffer_t;
+
+    // Frames are presented by a thread of their own while the next one is
+    // rendered. Window belongs to the thread that created it and only that
+    // thread receives its messages, so display is opened and used there only.
+    // Buffers rotate, one picked for the next frame is brought up to date with
+    // the frame just presented, so content persists like in a single buffer.
+    // Buffers keep intensity only, present thread expands it to
+    // PixelToaster::TrueColorPixel.
+    PixelToaster::Display  display;
+    std::vector<pixel_t>   buffers[present_queue_t::max_slots];
+    std::vector<PixelToaster::TrueColorPixel> converted;    // present thread only
+    present_queue_t        queue;
+    int                    colors_slot;
+    rect_t                 stale[present_queue_t::max_slots] = {}; // changed since buffer was current, render thread
+    std::atomic<int>       display_state { 0 }; // 0 - opening, 1 - open, 2 - closed
+    std::thread            presenter;
+    frame_sink_t*          capture = nullptr;   // receives every presented frame, render thread
+
+    toaster_framebuffer_t(const char* title, int width, int height, int zoom, PixelToaster::Listener* listener, int buffer_count = present_queue_t::max_slots, present_policy_t policy = present_policy_t::block):
+        gray8_framebuffer_t(width, height),
+        queue(buffer_count, policy)
+    {
+        for (int i = 0; i < queue.slot_count(); ++i)
+            buffers[i].assign(width * height, 0);
+        converted.resize(width * height);
+
+        colors_slot = queue.acquire();
+        colors      = buffers[colors_slot].data();
+
+        presenter = std::thread([this, title, zoom, listener] { present_main(title, zoom, listener); });
+
+        display_state.wait(0);
+    }
+
+    ~toaster_framebuffer_t()
+    {
+        queue.close();
+        presenter.join();
+    }
+
+    bool open() const
+    {
+        return display_state == 1;
+    }
+
+protected:
+    virtual void commit_impl() override final
+    {
+    }
+
+    virtual void present_impl() override final
+    {
+        if (capture)
+            capture->frame(colors, width, height, dirty_bounds);
+
+        queue.publish(colors_slot, dirty_bounds);
+
+        const auto presented = colors_slot;
+        for (int i = 0; i < queue.slot_count(); ++i)
+            if (i != presented)
+                stale[i] = merge_rects(stale[i], dirty_bounds);
+
+        // Closed queue leaves nobody reading the buffer, keep rendering to it
+        const auto slot = queue.acquire();
+        if (slot >= 0)
+            colors_slot = slot;
+
+        colors = buffers[colors_slot].data();
+
+        // Present thread only reads presented buffer, it can be read here too
+        if (colors_slot != presented)
+            copy_stale(buffers[presented].data());
+    }
+
+private:
+    void present_main(const char* title, int zoom, PixelToaster::Listener* listener);
+    void copy_stale(const pixel_t* presented);
+};